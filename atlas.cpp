@@ -0,0 +1,206 @@
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include "atlas.h"
+#include "render.h"
+
+using namespace std;
+
+SpriteAtlas::SpriteAtlas()
+	: _texture(nullptr)
+	, _dirty({ 0, 0, 0, 0 })
+	, _shelfy(0)
+	, _shelfh(0)
+	, _cursor(0)
+{
+	_surface = SDL_CreateRGBSurfaceWithFormat(0, 256, 256, 32, SDL_PIXELFORMAT_ARGB8888);
+	if (!_surface) {
+		cerr << "Failed to create surface: " << SDL_GetError() << endl;
+		exit(1);
+	}
+	SDL_FillRect(_surface, nullptr, 0);
+
+	// Solid texels for fills, sampled at the center so filtering can't bleed
+	_white = allocate(3, 3);
+	SDL_FillRect(_surface, &_white, 0xFFFFFFFF);
+	mark(_white);
+}
+
+SpriteAtlas::~SpriteAtlas()
+{
+	clear();
+	SDL_FreeSurface(_surface);
+}
+
+SpriteAtlas& SpriteAtlas::get_instance()
+{
+	static SpriteAtlas instance;
+	return instance;
+}
+
+SDL_Rect SpriteAtlas::allocate(int w, int h)
+{
+	// Shelf packing, sprites are few & small
+	if (_cursor + w > _surface->w) {
+		_shelfy += _shelfh + _pad;
+		_shelfh = 0;
+		_cursor = 0;
+	}
+	while (_shelfy + h > _surface->h || w > _surface->w)
+		grow();
+
+	SDL_Rect r = { _cursor, _shelfy, w, h };
+	_cursor += w + _pad;
+	_shelfh = std::max(_shelfh, h);
+	return r;
+}
+
+void SpriteAtlas::grow()
+{
+	// Double in size, a zero maximum means the renderer sets no limit
+	int maxw, maxh;
+	RenderWindow::get_instance().get_max_texture_size(&maxw, &maxh);
+	int w = (maxw ? std::min(_surface->w * 2, maxw) : _surface->w * 2);
+	int h = (maxh ? std::min(_surface->h * 2, maxh) : _surface->h * 2);
+	if (w == _surface->w && h == _surface->h) {
+		cerr << "UI atlas exceeds the maximum texture size" << endl;
+		exit(1);
+	}
+
+	// Copy over as is, the texture is re-created on the next flush
+	SDL_Surface* s = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+	if (!s) {
+		cerr << "Failed to create surface: " << SDL_GetError() << endl;
+		exit(1);
+	}
+	SDL_FillRect(s, nullptr, 0);
+	SDL_SetSurfaceBlendMode(_surface, SDL_BLENDMODE_NONE);
+	SDL_BlitSurface(_surface, nullptr, s, nullptr);
+	SDL_FreeSurface(_surface);
+	_surface = s;
+
+	SDL_DestroyTexture(_texture);
+	_texture = nullptr;
+}
+
+void SpriteAtlas::mark(const SDL_Rect& r)
+{
+	if (_dirty.w > 0 && _dirty.h > 0)
+		SDL_UnionRect(&_dirty, &r, &_dirty);
+	else
+		_dirty = r;
+}
+
+void SpriteAtlas::put(SDL_Rect* region, SDL_Surface* s)
+{
+	lock_guard<mutex> lk(_mut);
+
+	// Keep the sprite's region while its new contents fit
+	if (region->w < s->w || region->h < s->h)
+		*region = allocate(s->w, s->h);
+
+	// Replace pixels & alpha as they are
+	SDL_BlendMode mode;
+	SDL_GetSurfaceBlendMode(s, &mode);
+	SDL_SetSurfaceBlendMode(s, SDL_BLENDMODE_NONE);
+	SDL_FillRect(_surface, region, 0);
+	SDL_Rect dst = { region->x, region->y, s->w, s->h };
+	SDL_BlitSurface(s, nullptr, _surface, &dst);
+	SDL_SetSurfaceBlendMode(s, mode);
+	mark(*region);
+}
+
+void SpriteAtlas::push_quad(const SDL_Rect& src, const SDL_Rect& dst, const SDL_Color& c)
+{
+	// Texel coordinates, normalised on flush as the atlas may still grow
+	float u0 = (float)src.x;
+	float v0 = (float)src.y;
+	float u1 = (float)(src.x + src.w);
+	float v1 = (float)(src.y + src.h);
+	float x0 = (float)dst.x;
+	float y0 = (float)dst.y;
+	float x1 = (float)(dst.x + dst.w);
+	float y1 = (float)(dst.y + dst.h);
+
+	int base = (int)_vertices.size();
+	_vertices.push_back({ { x0, y0 }, c, { u0, v0 } });
+	_vertices.push_back({ { x1, y0 }, c, { u1, v0 } });
+	_vertices.push_back({ { x0, y1 }, c, { u0, v1 } });
+	_vertices.push_back({ { x1, y1 }, c, { u1, v1 } });
+	for (int i : { 0, 1, 2, 2, 1, 3 })
+		_indices.push_back(base + i);
+}
+
+void SpriteAtlas::queue(const SDL_Rect& src, const SDL_Rect& dst)
+{
+	lock_guard<mutex> lk(_mut);
+	push_quad(src, dst, { 0xFF, 0xFF, 0xFF, 0xFF });
+}
+
+void SpriteAtlas::queue(const SDL_Rect& src, const SDL_Rect& dst, const SDL_Color& c)
+{
+	// Tinted copy, e.g. text from white glyphs
+	lock_guard<mutex> lk(_mut);
+	push_quad(src, dst, c);
+}
+
+void SpriteAtlas::queue_fill(const SDL_Rect& dst, const SDL_Color& c)
+{
+	lock_guard<mutex> lk(_mut);
+	SDL_Rect src = { _white.x + 1, _white.y + 1, 0, 0 };
+	push_quad(src, dst, c);
+
+	// Collapse onto the texel center
+	float u = (float)_white.x + 1.5f;
+	float v = (float)_white.y + 1.5f;
+	for (size_t i = _vertices.size() - 4; i < _vertices.size(); ++i)
+		_vertices[i].tex_coord = { u, v };
+}
+
+void SpriteAtlas::flush(int x, int y)
+{
+	lock_guard<mutex> lk(_mut);
+	if (_indices.empty())
+		return;
+
+	SDL_Renderer* r = RenderWindow::get_instance().get_renderer();
+	if (!_texture) {
+		_texture = SDL_CreateTexture(r, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, _surface->w, _surface->h);
+		if (!_texture) {
+			cerr << "Failed to create texture: " << SDL_GetError() << endl;
+			exit(1);
+		}
+		SDL_SetTextureBlendMode(_texture, SDL_BLENDMODE_BLEND);
+		_dirty = { 0, 0, _surface->w, _surface->h };
+	}
+
+	// Upload changed sprites only
+	if (_dirty.w > 0 && _dirty.h > 0) {
+		const Uint8* p = (const Uint8*)_surface->pixels + _dirty.y * _surface->pitch + _dirty.x * 4;
+		SDL_UpdateTexture(_texture, &_dirty, p, _surface->pitch);
+		_dirty = { 0, 0, 0, 0 };
+	}
+
+	// Positions are relative to the given origin, e.g. of a render target
+	float w = (float)_surface->w;
+	float h = (float)_surface->h;
+	for (SDL_Vertex& v : _vertices) {
+		v.position.x -= (float)x;
+		v.position.y -= (float)y;
+		v.tex_coord.x /= w;
+		v.tex_coord.y /= h;
+	}
+
+	SDL_RenderGeometry(r, _texture, _vertices.data(), (int)_vertices.size(), _indices.data(), (int)_indices.size());
+	_vertices.clear();
+	_indices.clear();
+}
+
+void SpriteAtlas::clear()
+{
+	lock_guard<mutex> lk(_mut);
+	SDL_DestroyTexture(_texture);
+	_texture = nullptr;
+	_vertices.clear();
+	_indices.clear();
+}
\ No newline at end of file
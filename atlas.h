@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <mutex>
+#include <SDL.h>
+
+/* Single texture holding every UI sprite & text, so the whole bar is
+ * queued as quads and drawn with one geometry call per frame */
+class SpriteAtlas {
+	SDL_Surface* _surface;
+	SDL_Texture* _texture;
+	SDL_Rect _dirty;
+	SDL_Rect _white;
+	int _shelfy;
+	int _shelfh;
+	int _cursor;
+	std::vector<SDL_Vertex> _vertices;
+	std::vector<int> _indices;
+	mutable std::mutex _mut;
+
+	static const int _pad = 1;
+
+	SpriteAtlas();
+	SDL_Rect allocate(int, int);
+	void grow();
+	void mark(const SDL_Rect&);
+	void push_quad(const SDL_Rect&, const SDL_Rect&, const SDL_Color&);
+public:
+	SpriteAtlas(const SpriteAtlas&) = delete;
+	SpriteAtlas& operator=(const SpriteAtlas&) = delete;
+	~SpriteAtlas();
+
+	static SpriteAtlas& get_instance();
+
+	void put(SDL_Rect*, SDL_Surface*);
+	void queue(const SDL_Rect&, const SDL_Rect&);
+	void queue(const SDL_Rect&, const SDL_Rect&, const SDL_Color&);
+	void queue_fill(const SDL_Rect&, const SDL_Color&);
+	void flush(int = 0, int = 0);
+	void clear();
+};
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#include <type_traits>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <SDL.h>
+
+/* Surface size & repeats shared by the benchmarks, about a scanned
+ * page at print resolution */
+const int _w = 6000;
+const int _h = 9000;
+const int _runs = 10;
+
+/* Best of all runs of f, printed with its throughput in amount per
+ * second; surfaces f returns are freed outside the timing */
+template <typename F>
+double measure(const char* name, double amount, const char* unit, F f)
+{
+	Uint64 freq = SDL_GetPerformanceFrequency();
+	double best = 1e30;
+
+	for (int i = 0; i < _runs; ++i) {
+		Uint64 t0 = SDL_GetPerformanceCounter();
+		if constexpr (std::is_same_v<decltype(f()), SDL_Surface*>) {
+			SDL_Surface* out = f();
+			Uint64 t1 = SDL_GetPerformanceCounter();
+			SDL_FreeSurface(out);
+			best = std::min(best, (double)(t1 - t0) / (double)freq);
+		} else {
+			f();
+			Uint64 t1 = SDL_GetPerformanceCounter();
+			best = std::min(best, (double)(t1 - t0) / (double)freq);
+		}
+	}
+
+	std::cout << std::left << std::setw(12) << name << std::fixed << std::setprecision(2)
+		<< best * 1e3 << " ms  " << amount / best << " " << unit << std::endl;
+	return best;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+/* Compares SDL's generic blitter against the RGB24 -> 32-bit kernel
+ * used when converting decoded pages to the renderer's format.
+ *
+ * Build from the repository root, e.g.:
+ *   g++ -std=c++17 -O2 bench/convert.cpp convert.cpp -I. `sdl2-config --cflags --libs`
+ */
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <SDL.h>
+#include "convert.h"
+#include "bench.h"
+
+using namespace std;
+
+int main(int, char**)
+{
+	SDL_Surface* src = SDL_CreateRGBSurfaceWithFormat(0, _w, _h, 24, SDL_PIXELFORMAT_RGB24);
+	if (!src) {
+		cerr << "Failed to create surface: " << SDL_GetError() << endl;
+		return 1;
+	}
+
+	// Fill with noise so nothing is special-cased
+	Uint8* p = (Uint8*)src->pixels;
+	for (size_t i = 0; i < (size_t)src->pitch * _h; ++i)
+		p[i] = (Uint8)rand();
+
+	double mpix = (double)_w * (double)_h / 1e6;
+	for (Uint32 fmt : { SDL_PIXELFORMAT_ARGB8888, SDL_PIXELFORMAT_ABGR8888 }) {
+		cout << SDL_GetPixelFormatName(fmt) << " (" << _w << "x" << _h << ", best of " << _runs << ")" << endl;
+
+		double a = measure("SDL", mpix, "Mpix/s", [src, fmt]() {
+			return SDL_ConvertSurfaceFormat(src, fmt, 0);
+		});
+		double b = measure("Convert", mpix, "Mpix/s", [src, fmt]() {
+			return Convert::to_format(src, fmt);
+		});
+		cout << "speed-up    " << setprecision(2) << a / b << "x" << endl << endl;
+	}
+
+	SDL_FreeSurface(src);
+	return 0;
+}
\ No newline at end of file
@@ -1,11 +0,0 @@
-#pragma once
-#include "semaphore.h"
-
-class BSemaphore : public Semaphore {
-public:
-	BSemaphore(bool b = 0);
-
-	void up() override;
-	void down() override;
-	operator bool();
-};
\ No newline at end of file
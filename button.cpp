@@ -2,7 +2,7 @@
 #include <utility>
 #include <cstdlib>
 #include <SDL_image.h>
-#include "render.h"
+#include "atlas.h"
 #include "button.h"
 #include "util.h"
 
@@ -27,6 +27,7 @@ Button::Button(const fs::path& p)
 	// Initialize self as widget
 	_w = _surface->w;
 	_h = _surface->h / 4;
+	_rect.x = 0;
 	_rect.w = _w;
 	_rect.h = _h;
 
@@ -41,7 +42,6 @@ Button::Button(Button&& other)
 
 void Button::set_state(const State s) 
 {
-	aquire(_mut);
 	Widget::set_state(s);
 
 	/* Change texture rectangle position according
@@ -70,7 +70,7 @@ void Button::set_state(const State s)
 
 void Button::draw() const 
 {
-	aquire(_mut);
+	SDL_Rect src = { _region.x + _rect.x, _region.y + _rect.y, _rect.w, _rect.h };
 	SDL_Rect dst = { _x, _y, _w, _h };
-	RenderWindow::get_instance().render(_texture, &_rect, &dst);
+	SpriteAtlas::get_instance().queue(src, dst);
 }
\ No newline at end of file
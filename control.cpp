@@ -6,15 +6,26 @@
 #include <vector>
 #include <memory>
 #include <atomic>
-#include <mutex>
+#include <deque>
 #include <SDL.h>
-#include "bsemaphore.h"
+#include "surfcache.h"
+#include "texcache.h"
+#include "texpool.h"
+#include "frame.h"
+#include "atlas.h"
+#include "thumbcache.h"
+#include "scheduler.h"
+#include "msgqueue.h"
 #include "control.h"
 #include "render.h"
 #include "button.h"
 #include "widget.h"
 #include "image.h"
+#include "grid.h"
 #include "text.h"
+#include "page.h"
+#include "zip.h"
+#include "tar.h"
 #include "util.h"
 
 using namespace std;
@@ -39,17 +50,34 @@ Text* _percent;
 Text* _pagenum;
 unique_ptr<Text> _status;
 
-/* Program status & user event(s) */
-atomic_bool _run(true);
-atomic_bool _update(true);
+/* Program status, owned by the main thread like everything below */
+bool _run(true);
+bool _update(true);
+bool _uploading(false);
+
+/* Worker results, drained by the main thread; the user event only
+ * wakes the main loop */
+enum { LOADED, PREFETCHED, RESCALED, REDRAW };
+struct Message {
+	int code;
+	size_t index;
+	int scale;
+	unique_ptr<Image> image;
+};
+MessageQueue<Message> _inbox;
 Uint32 _uevnt;
 
 /* Paths & index */
-vector<fs::path> _paths;
-atomic_size_t _index(-1);
+vector<shared_ptr<Page>> _pages;
+size_t _index(-1);
 
 /* Image & friends */
 unique_ptr<Image> _image;
+unique_ptr<Grid> _grid;
+bool _gridmode(false);
+bool _loading(false);
+bool _dimmed(false);
+Uint32 _loadtick;
 SDL_Rect _rect;
 bool _drag(false);
 float _zoom(1.f);
@@ -62,44 +90,200 @@ RenderWindow* _win;
 int _winh;
 int _winw;
 SDL_Rect _bar;
+SDL_Texture* _bartex(nullptr);
+unsigned _barrev;
+bool _barvalid(false);
 unique_ptr<SDL_Cursor, function<void(SDL_Cursor*)>> _cursor(nullptr, [](SDL_Cursor* p) { SDL_FreeCursor(p); });
 
-/* Worker threads & sync */
-SDL_Thread* _worker;
-BSemaphore _sem;
-recursive_mutex _mut;
+/* Prefetch window: neighbouring pages decoded into the surface cache
+ * in the background, biased towards the last navigation direction */
+const size_t _ahead = 2;
+const size_t _behind = 1;
+const size_t _cachesize = 512 << 20;
+int _dir(1);
+
+/* Page the window is centred on, read by workers so decodes of pages
+ * still in the window survive a page turn */
+atomic_size_t _focus((size_t)-1);
+
+/* Prefetched neighbours waiting for their textures, uploaded one at a
+ * time with the frames the visible page leaves spare */
+deque<pair<size_t, int>> _preloads;
+SurfaceCache::Surface _presurf;
+string _prekey;
+Tiles _pretiles;
+
+/* Upper bound on idle sleeps, only guards against missed wakeups */
+const int _idletimeout = 1000;
+
+/* The previous page stays up while the next one decodes, dimmed once
+ * that takes long enough to notice; zero alpha disables dimming */
+const Uint32 _dimdelay = 150;
+const Uint8 _dimalpha = 96;
+
+void post(int code, size_t i = 0, int scale = 1, unique_ptr<Image> img = nullptr)
+{
+	// Any thread, the main loop picks the message up once woken
+	_inbox.push({ code, i, scale, move(img) });
 
-void draw()
+	SDL_Event evnt;
+	evnt.type = _uevnt;
+	SDL_PushEvent(&evnt);
+}
+
+int get_idle()
+{
+	// Wake up in time to dim a page that is still loading
+	if (!_loading || _dimmed || !_dimalpha)
+		return _idletimeout;
+
+	Uint32 t = SDL_GetTicks() - _loadtick;
+	return (int)(t < _dimdelay ? _dimdelay - t : 0);
+}
+
+void compose_bar(int x, int y)
 {
-	// Update textures
+	// Bar fill & widgets as one batch from the atlas
 	for_each(begin(_widgets), end(_widgets), [](auto& w) {
 		static_cast<Drawable*>(w.get())->update();
 	});
 
+	SpriteAtlas& atlas = SpriteAtlas::get_instance();
+	atlas.queue_fill(_bar, { 73, 73, 73, 0xFF });
+	for (auto& w : _widgets)
+		w->draw();
+	atlas.flush(x, y);
+}
+
+void draw_bar()
+{
 	SDL_Renderer* r = _win->get_renderer();
+
+	// (Re-)create the cached bar on resize
+	int w = 0, h = 0;
+	if (_bartex)
+		SDL_QueryTexture(_bartex, nullptr, nullptr, &w, &h);
+	if (!_bartex || w != _bar.w || h != _bar.h) {
+		SDL_DestroyTexture(_bartex);
+		_bartex = SDL_CreateTexture(r, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, _bar.w, _bar.h);
+		_barvalid = false;
+	}
+
+	// Draw directly where render targets aren't supported
+	if (!_bartex) {
+		compose_bar(0, 0);
+		return;
+	}
+
+	// Re-compose only after a widget changed, otherwise it's a single copy
+	unsigned rev = Widget::get_revision();
+	if (!_barvalid || rev != _barrev) {
+		SDL_SetRenderTarget(r, _bartex);
+		compose_bar(_bar.x, _bar.y);
+		SDL_SetRenderTarget(r, nullptr);
+		_barrev = rev;
+		_barvalid = true;
+	}
+	SDL_RenderCopy(r, _bartex, nullptr, &_bar);
+}
+
+vector<size_t> get_window(size_t i)
+{
+	// Order neighbours by distance, leading direction first
+	vector<size_t> v;
+	size_t n = _pages.size();
+	for (size_t d = 1; d <= std::max(_ahead, _behind); ++d) {
+		size_t next = (i + d) % n;
+		size_t prev = (i + n - d % n) % n;
+		if (_dir < 0)
+			swap(next, prev);
+
+		if (d <= _ahead && next != i && find(v.begin(), v.end(), next) == v.end())
+			v.push_back(next);
+		if (d <= _behind && prev != i && find(v.begin(), v.end(), prev) == v.end())
+			v.push_back(prev);
+	}
+	return v;
+}
+
+void preload(size_t i, int scale)
+{
+	// Queue a prefetched neighbour's upload so turning to it is a plain copy
+	pair<size_t, int> p(i, scale);
+	if (find(_preloads.begin(), _preloads.end(), p) == _preloads.end())
+		_preloads.push_back(p);
+	_update = true;
+}
+
+bool step_preload()
+{
+	// Pick the next neighbour still in the window & not yet uploaded
+	TextureCache& tc = TextureCache::get_instance();
+	while (!_presurf && !_preloads.empty()) {
+		auto [i, scale] = _preloads.front();
+		_preloads.pop_front();
+
+		vector<size_t> window = get_window(_index);
+		string key = Image::get_key(*_pages[i], scale);
+		if (find(window.begin(), window.end(), i) == window.end() || tc.contains(key))
+			continue;
+
+		_presurf = SurfaceCache::get_instance().find(key);
+		if (_presurf) {
+			_prekey = key;
+			_pretiles.begin(_presurf.get());
+		}
+	}
+	if (!_presurf)
+		return false;
+
+	// One frame's worth of stripes, more frames follow until done
+	if (_pretiles.step({ 0, 0, 0, 0 })) {
+		tc.put(_prekey, move(_pretiles));
+		_presurf.reset();
+	}
+	return true;
+}
+
+void draw()
+{
 	_win->clear(35, 35, 35);
 
-	{
-		// Draw image if loaded, status otherwise
-		unique_lock<recursive_mutex> lk(_mut, try_to_lock);
-		if (lk) {
-			static_cast<Drawable*>(_image.get())->update();
-			_image->draw(_rect);
-		} else {
-			static_cast<Drawable*>(_status.get())->update();
-			_status->draw();
+	// Draw image if loaded, status otherwise
+	if (_gridmode) {
+		_grid->update();
+		_grid->draw();
+		_uploading = !_grid->is_ready();
+	} else if (_image) {
+		static_cast<Drawable*>(_image.get())->update();
+		_image->draw(_rect);
+		_uploading = !_image->is_ready();
+
+		// Neighbours only upload once the visible page is complete
+		if (!_uploading)
+			_uploading = step_preload();
+
+		if (_dimmed) {
+			SDL_Renderer* r = _win->get_renderer();
+			SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
+			SDL_SetRenderDrawColor(r, 35, 35, 35, _dimalpha);
+			SDL_RenderFillRect(r, &_rect);
+			SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
 		}
+	} else {
+		static_cast<Drawable*>(_status.get())->update();
+		_status->draw();
 	}
 
-	// Draw UI bar
-	SDL_SetRenderDrawColor(r, 73, 73, 73, 0xFF);
-	SDL_RenderFillRect(r, &_bar);
+	// Status text is queued on the atlas
+	SpriteAtlas::get_instance().flush();
 
-	// Draw widgets
-	for (auto& w : _widgets)
-		w->draw();
+	draw_bar();
 
 	_win->display();
+
+	// Release textures over budget
+	TextureCache::get_instance().trim();
 }
 
 void drag(int dx, int dy)
@@ -149,8 +333,7 @@ void set_minzoom()
 void set_percent()
 {
 	// If image isn't ready use placeholder
-	unique_lock<recursive_mutex> lk(_mut, try_to_lock);
-	if (lk) {
+	if (_image) {
 		char buff[5];
 		sprintf_s(buff, 5, "%.0f%%", _zoom * 100.f);
 		_percent->set_string(buff);
@@ -165,6 +348,17 @@ void set_percent()
 	_update = true;
 }
 
+void set_status(const string& s)
+{
+	// Centred in the window, shown while there's no page
+	_status->set_string(s);
+
+	int w, h;
+	_status->get_size(&w, &h);
+	_status->set_position((_winw - w) / 2, (_winh - h) / 2);
+	_update = true;
+}
+
 void set_cursor(SDL_SystemCursor c)
 {
 	_cursor.reset(SDL_CreateSystemCursor(c));
@@ -172,6 +366,25 @@ void set_cursor(SDL_SystemCursor c)
 	_update = true;
 }
 
+void rescale()
+{
+	// Decode at a higher resolution once zoomed past the decoded one,
+	// unless the page is about to be replaced
+	int scale = Image::get_scale(_zoom);
+	if (_loading || scale >= _image->get_scale())
+		return;
+
+	// Into a new image, swapped in once complete
+	size_t i = _index;
+	Scheduler::get_instance().submit(Scheduler::VISIBLE, [i, scale](auto& t) {
+		// The current image stays should the page fail at this scale, a
+		// page turn stops the decode
+		auto img = Image::open(_pages[i], scale, [&t]() { return t.stale(); });
+		if (img && !t.stale())
+			post(RESCALED, i, scale, move(img));
+	});
+}
+
 void zoom(float f)
 {
 	_zoom = clamp(f, _minzoom, 2.f);
@@ -202,6 +415,9 @@ void zoom(float f)
 		center();
 	}
 
+	// Fetch higher resolution if needed
+	rescale();
+
 	// Update text
 	set_percent();
 
@@ -222,13 +438,6 @@ void fit()
 	zoom(_minzoom);
 }
 
-void push_event()
-{
-	SDL_Event evnt;
-	evnt.type = _uevnt;
-	SDL_PushEvent(&evnt);
-}
-
 Widget* find_widget(int x, int y)
 {
 	auto it = find_if(begin(_widgets), end(_widgets), [x, y](auto& w) {
@@ -247,6 +456,18 @@ void reset_widgets()
 	_update = true;
 }
 
+void focus_widget(Widget* f)
+{
+	// Touch only widgets whose state differs, each change re-composes the bar
+	for (auto& w : _widgets) {
+		Widget::State s = (w.get() == f ? Widget::FOCUSED : Widget::IDLE);
+		if (w->get_state() != Widget::DISABLED && w->get_state() != s) {
+			w->set_state(s);
+			_update = true;
+		}
+	}
+}
+
 void set_pagenum()
 {
 	char buff[6];
@@ -260,60 +481,197 @@ void set_pagenum()
 	_update = true;
 }
 
-int SDLCALL load(void* udata)
+bool in_window(size_t i)
 {
-	while (_run) {
-		_sem.down();
-
-		if (!_run)
-			return 0;
-
-		{
-			aquire(_mut);
-			_image.reset(new Image(_paths[_index]));
-		}
+	// Any thread, either side counts as the direction may have changed
+	size_t n = _pages.size();
+	size_t f = _focus;
+	if (f >= n)
+		return false;
+	size_t d = std::min((i + n - f) % n, (f + n - i) % n);
+	return d <= std::max(_ahead, _behind);
+}
 
-		push_event();
-	}
+void prefetch(size_t i, int vw, int vh, const Scheduler::Ticket& t)
+{
+	// Warm the surface cache incl. mipmaps, concurrent loads of a page are
+	// merged; a decode only stops once its page left the window, so the
+	// page turned to is picked up where its prefetch got to
+	int scale = Image::get_scale(*_pages[i], vw, vh);
+	Image::decode_levels(*_pages[i], scale, [&t, i]() { return t.stale() && !in_window(i); });
+	if (!t.stale())
+		post(PREFETCHED, i, scale);
+}
 
-	return 0;
+void load(size_t i, int vw, int vh, const Scheduler::Ticket& t)
+{
+	// Decode at fit-to-window scale or take from cache, a superseded decode
+	// stops early while a finished one stays cached; unreadable pages
+	// arrive without an image
+	int scale = Image::get_scale(*_pages[i], vw, vh);
+	auto img = Image::open(_pages[i], scale, [&t]() { return t.stale(); });
+	if (!t.stale())
+		post(LOADED, i, 1, move(img));
 }
 
 void load_index(size_t i)
 {
-	_index = clamp(i, (size_t)0, _paths.size() - 1);
+	i = clamp(i, (size_t)0, _pages.size() - 1);
+
+	// Remember navigation direction for prefetching (wrap-around aware)
+	size_t n = _pages.size();
+	bool initial = (_index >= n);
+	if (!initial && i != _index) {
+		if (i == (_index + 1) % n)
+			_dir = 1;
+		else if (i == (_index + n - 1) % n)
+			_dir = -1;
+		else
+			_dir = (i > _index ? 1 : -1);
+	}
+	_index = i;
+	_focus = i;
 
 	// Update window title & pagenum
-	fs::path p = _paths[_index];
+	fs::path p = _pages[_index]->get_name();
 	_win->set_title(p.filename().string() + " - Comix");
 	set_pagenum();
 
-	// Disable image operation widgets
-	for (int i = 0; i < 7; ++i)
-		_widgets[i]->set_state(Widget::DISABLED);
+	// Image operations need a page, the previous one stays usable
+	if (!_image) {
+		set_status("Loading...");
+		for (int i = 0; i < 7; ++i)
+			_widgets[i]->set_state(Widget::DISABLED);
+	}
+	set_percent();
 
-	// Set placeholder for percentage
-	_percent->set_string("---");
+	// Follow the page in the overview
+	if (_grid) {
+		_grid->set_current(i);
+		if (_gridmode)
+			_grid->scroll_to(i);
+	}
 
-	int w;
-	_percent->get_size(&w, nullptr);
-	_percent->set_position(26 + (35 - w) / 2, _bar.y);
+	// Supersede pending loads & queue the new page, the first one joins
+	// the decode started while the directory was enumerated; running
+	// prefetches of pages still in the window carry on
+	_loading = true;
+	_dimmed = false;
+	_loadtick = SDL_GetTicks();
+	Scheduler& s = Scheduler::get_instance();
+	if (!initial) {
+		s.cancel(Scheduler::VISIBLE);
+		s.cancel(Scheduler::PREFETCH);
+	}
+	int vw = _winw;
+	int vh = _winh;
+	s.submit(Scheduler::VISIBLE, [i, vw, vh](auto& t) {
+		load(i, vw, vh, t);
+	});
+	_update = true;
+}
+
+void show_grid(bool on)
+{
+	_gridmode = on;
+
+	if (on) {
+		// Thumbnails are only made once the overview is first opened
+		if (!_grid)
+			_grid = make_unique<Grid>(_pages, []() { post(REDRAW); });
+		_grid->set_viewport({ 0, 0, _winw, _winh });
+		_grid->set_current(_index);
+		_grid->scroll_to(_index);
+	}
 
-	// Let worker thread start
-	_sem.up();
+	// Image operations only apply to the page view
+	for (int i = 0; i < 7; ++i)
+		_widgets[i]->set_state(on || !_image ? Widget::DISABLED : Widget::IDLE);
+
+	_drag = false;
+	set_cursor(SDL_SYSTEM_CURSOR_ARROW);
 	_update = true;
 }
 
-int SDLCALL handle(void* udata, SDL_Event* evnt)
+void open_page(size_t i)
+{
+	// Leave the overview for the chosen page
+	show_grid(false);
+	if (i != _index)
+		load_index(i);
+}
+
+void receive(Message& m)
 {
-    // Stop processing after main loop exit
-	if (!_run)
-		return 0;
+	switch (m.code) {
+		case PREFETCHED:
+		{
+			vector<size_t> window = get_window(_index);
+			if (find(window.begin(), window.end(), m.index) != window.end())
+				preload(m.index, m.scale);
+			break;
+		}
+		case RESCALED:
+			// Swap in the sharper image, the view stays as it is
+			if (_image && !_loading && m.index == _index && m.scale < _image->get_scale()) {
+				m.image->set_orientation(_image->get_orientation());
+				_image = move(m.image);
+			}
+			_update = true;
+			break;
+		case REDRAW:
+			_update = true;
+			break;
+		case LOADED:
+		{
+			// Superseded while decoding
+			if (m.index != _index)
+				break;
+
+			// Replaces the previous page in one go, it was shown until now
+			_image = move(m.image);
+			_loading = false;
+			_dimmed = false;
+
+			// Unreadable page, say so in its place
+			if (!_image) {
+				set_status("Cannot read " + _pages[m.index]->get_name());
+				for (int i = 0; i < 7; ++i)
+					_widgets[i]->set_state(Widget::DISABLED);
+				set_percent();
+				break;
+			}
+
+			// Re-enable widgets, unless showing the overview
+			for (int i = 0; i < 7 && !_gridmode; ++i)
+				_widgets[i]->set_state(Widget::IDLE);
+
+			fit();
+
+			// Queue neighbours behind the visible page
+			Scheduler& s = Scheduler::get_instance();
+			for (size_t j : get_window(_index)) {
+				s.submit(Scheduler::PREFETCH, [j, vw = _winw, vh = _winh](auto& t) {
+					prefetch(j, vw, vh, t);
+				});
+			}
+			break;
+		}
+	}
+}
 
+void handle(const SDL_Event* evnt)
+{
 	switch (evnt->type) {
 		case SDL_QUIT:
 			_run = false;
 			break;
+		case SDL_RENDER_TARGETS_RESET:
+		case SDL_RENDER_DEVICE_RESET:
+			// Target contents are lost
+			_barvalid = false;
+			_update = true;
+			break;
 		case SDL_WINDOWEVENT:
 		{
 			SDL_WindowEvent we = evnt->window;
@@ -329,6 +687,7 @@ int SDLCALL handle(void* udata, SDL_Event* evnt)
 				{
 					// Update window dimensions & related variables
 					_win->get_size(&_winw, &_winh);
+					FrameScheduler::get_instance().set_refresh_rate(_win->get_refresh_rate());
 
 					_bar = { 0, _winh - 17, _winw, 17 };
 					_winh -= _bar.h;
@@ -355,22 +714,21 @@ int SDLCALL handle(void* udata, SDL_Event* evnt)
 					_widgets[11]->set_position(_winw - 20, y);
 
 					// Status text
-					int w, h;
-					_status->get_size(&w, &h);
-					_status->set_position((_winw - w) / 2, (_winh - h) / 2);
+					set_status(_status->get_string());
 
 					// Adjust image (if loaded)
-                    try_aquire(_mut) 
-                    {
-                        if (_zoom == _minzoom) {
-                            fit();
-                        } else {
-                            _focusx = _rect.x;
-                            _focusy = _rect.y;
-                            set_minzoom();
-                            zoom(_zoom);
-                        }
-                    }
+					if (_grid)
+						_grid->set_viewport({ 0, 0, _winw, _winh });
+					if (!_image)
+						break;
+					if (_zoom == _minzoom) {
+						fit();
+					} else {
+						_focusx = _rect.x;
+						_focusy = _rect.y;
+						set_minzoom();
+						zoom(_zoom);
+					}
 					break;
 				}
 			}
@@ -389,39 +747,60 @@ int SDLCALL handle(void* udata, SDL_Event* evnt)
 				_widgets[10]->trigger();
 			}
 
+            // Page overview
+            if (sym == SDLK_TAB || sym == SDLK_g) {
+                show_grid(!_gridmode);
+            } else if (_gridmode) {
+                int row = _grid->get_row_height();
+                if (sym == SDLK_ESCAPE)
+                    show_grid(false);
+                if (sym == SDLK_RETURN)
+                    open_page(_index);
+                if (sym == SDLK_UP)
+                    _grid->scroll(-row);
+                if (sym == SDLK_DOWN)
+                    _grid->scroll(row);
+                if (sym == SDLK_PAGEUP)
+                    _grid->scroll(-_winh);
+                if (sym == SDLK_PAGEDOWN)
+                    _grid->scroll(_winh);
+                if (sym == SDLK_HOME)
+                    _grid->scroll_to(0);
+                if (sym == SDLK_END)
+                    _grid->scroll_to(_pages.size() - 1);
+                _update = true;
+            }
+
             // Image operations (if loaded)
-            try_aquire(_mut)
-            {
-                if (_zoom > _minzoom) {
-                    if (sym == SDLK_UP
-                        || sym == SDLK_PAGEUP)
-                        drag(0, (int)(_rect.h * .02f));
-                    if (sym == SDLK_DOWN
-                        || sym == SDLK_PAGEDOWN)
-                        drag(0, (int)(_rect.h * -.02f));
-                    if (sym == SDLK_HOME)
-                        _rect.y = 0;
-                    if (sym == SDLK_END)
-                        _rect.y = _winh - _rect.h;
-                    _update = true;
-                }
+            if (_image && !_gridmode && _zoom > _minzoom) {
+                if (sym == SDLK_UP
+                    || sym == SDLK_PAGEUP)
+                    drag(0, (int)(_rect.h * .02f));
+                if (sym == SDLK_DOWN
+                    || sym == SDLK_PAGEDOWN)
+                    drag(0, (int)(_rect.h * -.02f));
+                if (sym == SDLK_HOME)
+                    _rect.y = 0;
+                if (sym == SDLK_END)
+                    _rect.y = _winh - _rect.h;
+                _update = true;
+            }
 
-                // Zoom, fit & fill
-                if (key.mod & KMOD_CTRL) {
-                    switch (sym) {
-                        case SDLK_EQUALS:
-                            _widgets[2]->trigger();
-                            break;
-                        case SDLK_MINUS:
-                            _widgets[0]->trigger();
-                            break;
-                        case SDLK_0:
-                            zoom(1.f);
-                            break;
-                        case SDLK_1:
-                            fit();
-                            break;
-                    }
+            // Zoom, fit & fill
+            if (_image && !_gridmode && (key.mod & KMOD_CTRL)) {
+                switch (sym) {
+                    case SDLK_EQUALS:
+                        _widgets[2]->trigger();
+                        break;
+                    case SDLK_MINUS:
+                        _widgets[0]->trigger();
+                        break;
+                    case SDLK_0:
+                        zoom(1.f);
+                        break;
+                    case SDLK_1:
+                        fit();
+                        break;
                 }
             }
 
@@ -431,10 +810,12 @@ int SDLCALL handle(void* udata, SDL_Event* evnt)
 		}
 		case SDL_MOUSEWHEEL:
 		{
-            try_aquire(_mut)
-            {
-                SDL_MouseWheelEvent mwe = evnt->wheel;
-
+            SDL_MouseWheelEvent mwe = evnt->wheel;
+            if (_gridmode) {
+                // Scroll the overview by half a row per notch
+                _grid->scroll(-mwe.y * _grid->get_row_height() / 2);
+                _update = true;
+            } else if (_image) {
                 // If mouse is outside image, use center as focus
                 SDL_GetMouseState(&_focusx, &_focusy);
                 if (_focusx < _rect.x || _focusx > _rect.x + _rect.w ||
@@ -463,10 +844,7 @@ int SDLCALL handle(void* udata, SDL_Event* evnt)
                 _update = true;
 			} else { 
                 // Start dragging (clicked anywhere above bar & image loaded)
-                try_aquire(_mut)
-                {
-				    _drag = mbe.y < _bar.y && (_rect.w > _winw || _rect.h > _winh);
-                }
+                _drag = _image && !_gridmode && mbe.y < _bar.y && (_rect.w > _winw || _rect.h > _winh);
 			}
 			break;
 		}
@@ -482,6 +860,11 @@ int SDLCALL handle(void* udata, SDL_Event* evnt)
 				w->set_state(Widget::FOCUSED);
 			} else {
 				reset_widgets();
+
+				// Page picked from the overview
+				int i = (_gridmode && mbe.y < _bar.y ? _grid->get_index(mbe.x, mbe.y) : -1);
+				if (i >= 0)
+					open_page((size_t)i);
 			}
 
 			// Stop dragging
@@ -496,39 +879,48 @@ int SDLCALL handle(void* udata, SDL_Event* evnt)
 				drag(mme.xrel, mme.yrel);
 			} else if (!mme.state) {
 				// Moved on-top of widget
-				reset_widgets();
-				Widget* w = find_widget(mme.x, mme.y);
-				if (w != nullptr) {
-					w->set_state(Widget::FOCUSED);
-				}
+				focus_widget(find_widget(mme.x, mme.y));
 
 				// Update cursor
-				set_cursor(mme.y < _bar.y
+				set_cursor(!_gridmode && mme.y < _bar.y
 					&& (_rect.w > _winw || _rect.h > _winh)
 					? SDL_SYSTEM_CURSOR_SIZEALL
 					: SDL_SYSTEM_CURSOR_ARROW);
 			}
 			break;
 		}
-        default:
-            // Process user event (i.e. image load complete)
-            if (evnt->type == _uevnt) {
-
-                // Re-enable widgets
-                for (int i = 0; i < 7; ++i)
-                    _widgets[i]->set_state(Widget::IDLE);
-                
-                fit();
-            }
 	}
+}
+
+void sort_pages()
+{
+	// Natural page order, keys are computed once per page
+	vector<pair<string, shared_ptr<Page>>> v;
+	v.reserve(_pages.size());
+	for (auto& p : _pages)
+		v.emplace_back(Util::get_sort_key(p->get_name()), move(p));
+
+	sort(v.begin(), v.end(), [](auto& a, auto& b) {
+		return a.first < b.first;
+	});
+	for (size_t i = 0; i < v.size(); ++i)
+		_pages[i] = move(v[i].second);
+}
 
-	// Draw components
-	if (_update) {
-		_update = false;
-		draw();
+bool open_archive(const fs::path& p)
+{
+	// Index the archive once, its image members become the pages
+	if (Util::is_tar(p)) {
+		auto tar = Tar::open(p);
+		if (tar)
+			_pages = tar->get_pages();
+		return (bool)tar;
 	}
 
-	return 0;
+	auto zip = Zip::open(p);
+	if (zip)
+		_pages = zip->get_pages();
+	return (bool)zip;
 }
 
 void Control::init(fs::path path)
@@ -539,33 +931,58 @@ void Control::init(fs::path path)
 		exit(1);
 	}
 
-	// Get parent directory
-	fs::path first;
-	if (!fs::is_directory(path)) {
-		if (!Util::is_image(path)) {
-			cerr << path << " is not an image" << endl;
+	// Create window & renderer
+	_win = &RenderWindow::get_instance();
+
+	// Initial viewport for choosing the decode scale
+	_win->get_size(&_winw, &_winh);
+	_winh -= 17;
+
+	// Set decoded page budget
+	SurfaceCache::get_instance().set_budget(_cachesize);
+
+	// Open archives in place, their members become the pages
+	shared_ptr<FilePage> first;
+	if (Util::is_archive(path)) {
+		if (!open_archive(path)) {
+			cerr << path << " is not a readable archive" << endl;
 			exit(1);
 		}
-		first = path;
-		path = path.parent_path();
-	}
+	} else {
+		// Get parent directory
+		if (!fs::is_directory(path)) {
+			if (!Util::is_image(path)) {
+				cerr << path << " is not an image" << endl;
+				exit(1);
+			}
 
-	// Discover image files
-	fs::directory_iterator directory(path);
-	for (auto &it : directory) {
-		fs::path p = it.path();
-		if (Util::is_image(p))
-			_paths.push_back(p);
+			// Decode the requested page while the directory is enumerated
+			first = make_shared<FilePage>(path);
+			Scheduler::get_instance().submit(Scheduler::VISIBLE, [first, w = _winw, h = _winh](auto&) {
+				Image::decode_levels(*first, Image::get_scale(*first, w, h));
+			});
+			_pages.push_back(first);
+
+			path = path.parent_path();
+			if (path.empty())
+				path = ".";
+		}
+
+		// Discover image files, stepping with the error code so a failing
+		// entry ends the scan instead of throwing
+		error_code ec;
+		for (fs::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec)) {
+			if (Util::is_image(*it) && (!first || it->path().filename() != first->get_path().filename()))
+				_pages.push_back(make_shared<FilePage>(it->path()));
+		}
 	}
 
     // Check images found in path
-    if (_paths.empty()) {
+    if (_pages.empty()) {
 		cerr << path << " does not contain any images" << endl;
 		exit(1);
 	}
-
-	// Create window & renderer
-	_win = &RenderWindow::get_instance();
+	sort_pages();
 
     // Register user event(s)
     if ((_uevnt = SDL_RegisterEvents(1)) == ((Uint32)-1)) {
@@ -638,7 +1055,7 @@ void Control::init(fs::path path)
 	_widgets[8]->set_handler([&](Widget& w) {
 		size_t i = _index - 1;
 		if (i < 0)
-			i = _paths.size() - 1;
+			i = _pages.size() - 1;
 		load_index(i);
 	});
 
@@ -651,20 +1068,20 @@ void Control::init(fs::path path)
 	_widgets[10] = make_unique<Button>(Util::get_respath("ui_right.png"));
 	_widgets[10]->set_handler([&](Widget& w) {
 		size_t i = _index + 1;
-		if (i >= _paths.size())
+		if (i >= _pages.size())
 			i = 0;
 		load_index(i);
 	});
 
 	_widgets[11] = make_unique<Button>(Util::get_respath("ui_last.png"));
 	_widgets[11]->set_handler([&](Widget& w) {
-		load_index(_paths.size() - 1);
+		load_index(_pages.size() - 1);
 	});
 
 	_status = make_unique<Text>("Loading...");
 
     // Disable navigation when viewing a single image
-    if (_paths.size() == 1) {
+    if (_pages.size() == 1) {
 		_widgets[7]->set_state(Widget::DISABLED);
 		_widgets[8]->set_state(Widget::DISABLED);
 		_widgets[9]->set_state(Widget::DISABLED);
@@ -672,25 +1089,79 @@ void Control::init(fs::path path)
 		_widgets[11]->set_state(Widget::DISABLED);
 	}
 
-	// Create image loading worker thread
-	_worker = SDL_CreateThread(load, "th-image", nullptr);
-
-	// Add event watcher
-	SDL_AddEventWatch(handle, nullptr);
-
     // Get initial index & load first image
-	auto found = find(_paths.begin(), _paths.end(), first);
-	load_index((found == _paths.end() ? 0 : distance(_paths.begin(), found)));
+	auto found = find(_pages.begin(), _pages.end(), first);
+	load_index((found == _pages.end() ? 0 : distance(_pages.begin(), found)));
 }
 
 void Control::loop()
 {
-    // Main loop
+    // Main loop, sleeps until input, a worker's event or the next frame
+    FrameScheduler& frames = FrameScheduler::get_instance();
+    SDL_Event evnt;
     while (_run) {
-        SDL_PumpEvents();
+        // Keep drawing while textures upload stripe by stripe
+        if (_uploading)
+            frames.request();
+
+        int timeout = frames.get_timeout(get_idle());
+        bool got = (timeout
+            ? SDL_WaitEventTimeout(&evnt, timeout)
+            : SDL_PollEvent(&evnt));
+
+        // Handle everything queued, changes add up to a single frame
+        while (got && _run) {
+            handle(&evnt);
+            got = SDL_PollEvent(&evnt);
+        }
+
+        // Take in worker results, the wake-up events carry none
+        Message m;
+        while (_run && _inbox.pop(m))
+            receive(m);
+
+        // Dim the previous page once loading is noticeably slow
+        if (_loading && !_dimmed && _dimalpha && SDL_GetTicks() - _loadtick >= _dimdelay) {
+            _dimmed = true;
+            _update = true;
+        }
+        if (_update) {
+            _update = false;
+            frames.request();
+        }
+
+        // Draw components, at most once per refresh
+        if (_run && frames.begin()) {
+            draw();
+            frames.end();
+        }
     }
 
-    // Join worker thread
-    _sem.up();
-    SDL_WaitThread(_worker, NULL);
+    // Join worker threads & drop their unclaimed results
+    Scheduler::get_instance().stop();
+    Message m;
+    while (_inbox.pop(m))
+        ;
+
+    // Release textures while the renderer is still alive
+    _image.reset();
+    _grid.reset();
+    _pretiles.clear();
+    _presurf.reset();
+    SDL_DestroyTexture(_bartex);
+    SpriteAtlas::get_instance().clear();
+    TextureCache::get_instance().clear();
+    TexturePool::get_instance().clear();
+
+#ifndef NDEBUG
+    // Report cache usage for budget tuning
+    SurfaceCache::Stats st = SurfaceCache::get_instance().get_stats();
+    cerr << "Surface cache: " << st.hits << " hits, " << st.misses << " misses, "
+        << st.evictions << " evictions, " << st.entries << " entries ("
+        << (st.bytes >> 20) << "/" << (_cachesize >> 20) << " MiB)" << endl;
+
+    // Report frame pacing
+    FrameScheduler::Stats fst = frames.get_stats();
+    cerr << "Frames: " << fst.frames << " drawn, " << fst.dropped << " dropped" << endl;
+#endif
 }
\ No newline at end of file
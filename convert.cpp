@@ -0,0 +1,100 @@
+#include "convert.h"
+#include "simd.h"
+
+using namespace std;
+
+#ifdef SIMD_X86
+/* Expands 4 packed RGB24 pixels per 16 byte load into 32-bit pixels,
+ * reads 4 bytes past the last pixel so the caller keeps a margin */
+TARGET_SSSE3
+static size_t rgb24_to_32_ssse3(const Uint8* src, Uint32* dst, size_t n, bool swap)
+{
+	const __m128i shuf = swap
+		? _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1)
+		: _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+
+	size_t i = 0;
+	for (; n - i >= 18; i += 16) {
+		const Uint8* s = src + i * 3;
+		__m128i a = _mm_loadu_si128((const __m128i*)(s));
+		__m128i b = _mm_loadu_si128((const __m128i*)(s + 12));
+		__m128i c = _mm_loadu_si128((const __m128i*)(s + 24));
+		__m128i d = _mm_loadu_si128((const __m128i*)(s + 36));
+
+		__m128i* out = (__m128i*)(dst + i);
+		_mm_storeu_si128(out, _mm_or_si128(_mm_shuffle_epi8(a, shuf), alpha));
+		_mm_storeu_si128(out + 1, _mm_or_si128(_mm_shuffle_epi8(b, shuf), alpha));
+		_mm_storeu_si128(out + 2, _mm_or_si128(_mm_shuffle_epi8(c, shuf), alpha));
+		_mm_storeu_si128(out + 3, _mm_or_si128(_mm_shuffle_epi8(d, shuf), alpha));
+	}
+	return i;
+}
+#endif
+
+bool Convert::is_supported(Uint32 fmt)
+{
+	return fmt == SDL_PIXELFORMAT_ARGB8888 || fmt == SDL_PIXELFORMAT_ABGR8888
+		|| fmt == SDL_PIXELFORMAT_RGB888 || fmt == SDL_PIXELFORMAT_BGR888;
+}
+
+void Convert::rgb24_to_32_scalar(const Uint8* src, Uint32* dst, size_t n, bool swap)
+{
+	// Red in the low byte when swapped (ABGR/BGR), high byte otherwise
+	int rs = swap ? 0 : 16;
+	int bs = swap ? 16 : 0;
+	for (size_t i = 0; i < n; ++i, src += 3) {
+		dst[i] = 0xFF000000u
+			| ((Uint32)src[0] << rs)
+			| ((Uint32)src[1] << 8)
+			| ((Uint32)src[2] << bs);
+	}
+}
+
+void Convert::rgb24_to_32(const Uint8* src, Uint32* dst, size_t n, bool swap)
+{
+	size_t i = 0;
+#if defined(SIMD_X86) && SDL_BYTEORDER == SDL_LIL_ENDIAN
+	static const bool ssse3 = SDL_HasSSSE3();
+	if (ssse3)
+		i = rgb24_to_32_ssse3(src, dst, n, swap);
+#endif
+	rgb24_to_32_scalar(src + i * 3, dst + i, n - i, swap);
+}
+
+SDL_Surface* Convert::to_format(SDL_Surface* s, Uint32 fmt)
+{
+	if (s->format->format == fmt)
+		return s;
+
+	// Generic fallback for anything but RGB24 sources
+	if (s->format->format != SDL_PIXELFORMAT_RGB24 || !is_supported(fmt)) {
+		SDL_Surface* out = SDL_ConvertSurfaceFormat(s, fmt, 0);
+		return out ? out : s;
+	}
+
+	SDL_Surface* out = SDL_CreateRGBSurfaceWithFormat(0, s->w, s->h, 32, fmt);
+	if (!out)
+		return s;
+
+	bool swap = (fmt == SDL_PIXELFORMAT_ABGR8888 || fmt == SDL_PIXELFORMAT_BGR888);
+	for (int y = 0; y < s->h; ++y) {
+		rgb24_to_32(
+			(const Uint8*)s->pixels + y * s->pitch,
+			(Uint32*)((Uint8*)out->pixels + y * out->pitch),
+			(size_t)s->w,
+			swap
+		);
+	}
+	return out;
+}
+
+SDL_Surface* Convert::to_bytes(SDL_Surface* s, bool packed)
+{
+	// Box filters work on whole bytes, normalise odd formats first;
+	// 24-bit pixels pass where the filter takes them
+	int size = s->format->BytesPerPixel;
+	if (size == 4 || (packed && size == 3))
+		return s;
+	return SDL_ConvertSurfaceFormat(s, SDL_PIXELFORMAT_ARGB8888, 0);
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+#include <SDL.h>
+
+class Convert {
+public:
+	static bool is_supported(Uint32);
+	static void rgb24_to_32(const Uint8*, Uint32*, size_t, bool);
+	static void rgb24_to_32_scalar(const Uint8*, Uint32*, size_t, bool);
+	static SDL_Surface* to_format(SDL_Surface*, Uint32);
+	static SDL_Surface* to_bytes(SDL_Surface*, bool = false);
+};
\ No newline at end of file
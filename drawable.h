@@ -3,13 +3,12 @@
 
 class Drawable {
 protected:
-	SDL_Texture* _texture;
 	SDL_Surface* _surface;
 	bool _uflag;
 
 public:
-	Drawable() = default;
+	Drawable();
 	Drawable(Drawable&&);
-	~Drawable();
-	void update();
+	virtual ~Drawable();
+	virtual void update() = 0;
 };
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "flip.h"
+#include "simd.h"
+
+using namespace std;
+
+template <int N>
+static void reverse_row(Uint8* row, int w)
+{
+	Pixel<N>* p = (Pixel<N>*)row;
+	for (int i = 0, j = w - 1; i < j; ++i, --j)
+		swap(p[i], p[j]);
+}
+
+#ifdef SIMD_X86
+/* Reverses the order of the N byte lanes of a vector */
+template <int N>
+struct Lanes;
+
+template <>
+struct Lanes<4> {
+	TARGET_SSE2 static __m128i reverse(__m128i v)
+	{
+		return _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+	}
+};
+
+template <>
+struct Lanes<2> {
+	TARGET_SSE2 static __m128i reverse(__m128i v)
+	{
+		v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+		v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+		return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+	}
+};
+
+template <>
+struct Lanes<1> {
+	TARGET_SSE2 static __m128i reverse(__m128i v)
+	{
+		v = Lanes<2>::reverse(v);
+		return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+	}
+};
+
+template <int N>
+TARGET_SSE2
+static void reverse_row_sse2(Uint8* row, int w)
+{
+	// Swap vectors from both ends, the middle goes scalar
+	const int n = 16 / N;
+	int i = 0;
+	int j = w;
+	for (; j - i >= 2 * n; i += n, j -= n) {
+		__m128i* a = (__m128i*)(row + (size_t)i * N);
+		__m128i* b = (__m128i*)(row + (size_t)(j - n) * N);
+		__m128i va = _mm_loadu_si128(a);
+		__m128i vb = _mm_loadu_si128(b);
+		_mm_storeu_si128(a, Lanes<N>::reverse(vb));
+		_mm_storeu_si128(b, Lanes<N>::reverse(va));
+	}
+	reverse_row<N>(row + (size_t)i * N, j - i);
+}
+#endif
+
+template <int N>
+static void reverse_rows(SDL_Surface* s)
+{
+	Uint8* p = (Uint8*)s->pixels;
+
+#ifdef SIMD_X86
+	// 24-bit pixels don't divide a vector, those stay scalar
+	if constexpr (N != 3) {
+		static const bool sse2 = SDL_HasSSE2();
+		if (sse2) {
+			for (int y = 0; y < s->h; ++y)
+				reverse_row_sse2<N>(p + (size_t)y * s->pitch, s->w);
+			return;
+		}
+	}
+#endif
+
+	for (int y = 0; y < s->h; ++y)
+		reverse_row<N>(p + (size_t)y * s->pitch, s->w);
+}
+
+void Flip::rows(SDL_Surface* s)
+{
+	// Swap rows pairwise through a buffer small enough to stay in L1
+	Uint8 buf[_chunk];
+	Uint8* p = (Uint8*)s->pixels;
+	size_t bytes = (size_t)s->w * s->format->BytesPerPixel;
+
+	for (int y = 0; y < s->h / 2; ++y) {
+		Uint8* a = p + (size_t)y * s->pitch;
+		Uint8* b = p + (size_t)(s->h - 1 - y) * s->pitch;
+		for (size_t i = 0; i < bytes; i += _chunk) {
+			size_t n = std::min(_chunk, bytes - i);
+			memcpy(buf, a + i, n);
+			memcpy(a + i, b + i, n);
+			memcpy(b + i, buf, n);
+		}
+	}
+}
+
+void Flip::columns(SDL_Surface* s)
+{
+	switch (s->format->BytesPerPixel) {
+		case 1:
+			reverse_rows<1>(s);
+			break;
+		case 2:
+			reverse_rows<2>(s);
+			break;
+		case 3:
+			reverse_rows<3>(s);
+			break;
+		default:
+			reverse_rows<4>(s);
+			break;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#pragma once
+#include <SDL.h>
+
+/* In-place mirroring of surface pixels. Rows are swapped end for end in
+ * chunks & pixels reversed within rows by kernels specialised per pixel
+ * size, using SSE2 for 8, 16 & 32-bit pixels */
+class Flip {
+	static constexpr size_t _chunk = 4096;
+public:
+	static void rows(SDL_Surface*);
+	static void columns(SDL_Surface*);
+};
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include "frame.h"
+#include "render.h"
+
+using namespace std;
+
+FrameScheduler::FrameScheduler()
+	: _last(0)
+	, _requested(0)
+	, _pending(false)
+	, _stats({ 0, 0 })
+{
+	RenderWindow& win = RenderWindow::get_instance();
+	_vsync = (win.get_info().flags & SDL_RENDERER_PRESENTVSYNC) != 0;
+	set_refresh_rate(win.get_refresh_rate());
+}
+
+FrameScheduler& FrameScheduler::get_instance()
+{
+	static FrameScheduler instance;
+	return instance;
+}
+
+void FrameScheduler::set_refresh_rate(int hz)
+{
+	if (hz <= 0)
+		hz = _fallbackrate;
+	_period = SDL_GetPerformanceFrequency() / (Uint64)hz;
+}
+
+void FrameScheduler::request()
+{
+	// Only the first change since the last frame sets when it's due
+	if (!_pending)
+		_requested = SDL_GetPerformanceCounter();
+	_pending = true;
+}
+
+int FrameScheduler::get_timeout(int idle) const
+{
+	if (!_pending)
+		return idle;
+	if (_vsync)
+		return 0;
+
+	// Time left in the current refresh period, rounded up
+	Uint64 now = SDL_GetPerformanceCounter();
+	Uint64 next = _last + _period;
+	if (now >= next)
+		return 0;
+	Uint64 freq = SDL_GetPerformanceFrequency();
+	return (int)(((next - now) * 1000 + freq - 1) / freq);
+}
+
+bool FrameScheduler::begin()
+{
+	if (!_pending)
+		return false;
+
+	// Without vsync hold off until the refresh period is over
+	if (!_vsync && SDL_GetPerformanceCounter() < _last + _period)
+		return false;
+
+	_pending = false;
+	return true;
+}
+
+void FrameScheduler::end()
+{
+	// Due one period after the last frame at the earliest
+	Uint64 now = SDL_GetPerformanceCounter();
+	Uint64 due = std::max(_requested, _last + _period);
+	if (_last && now > due)
+		_stats.dropped += (size_t)((now - due) / _period);
+
+	_last = now;
+	++_stats.frames;
+}
+
+FrameScheduler::Stats FrameScheduler::get_stats() const
+{
+	return _stats;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <SDL.h>
+
+/* Paces drawing to the display; changes between frames are coalesced
+ * into a single draw, at most one per refresh, either blocking in a
+ * vsynced present or by waiting out the refresh period. Frames shown
+ * a whole period or more after they were due count as dropped */
+class FrameScheduler {
+public:
+	struct Stats {
+		size_t frames;
+		size_t dropped;
+	};
+
+private:
+	Uint64 _period;
+	Uint64 _last;
+	Uint64 _requested;
+	bool _pending;
+	bool _vsync;
+	Stats _stats;
+
+	static const int _fallbackrate = 60;
+
+	FrameScheduler();
+public:
+	FrameScheduler(const FrameScheduler&) = delete;
+	FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+	static FrameScheduler& get_instance();
+
+	void set_refresh_rate(int);
+	void request();
+	int get_timeout(int) const;
+
+	bool begin();
+	void end();
+
+	Stats get_stats() const;
+};
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include <algorithm>
+#include "glyphcache.h"
+#include "atlas.h"
+
+using namespace std;
+
+GlyphCache& GlyphCache::get_instance()
+{
+	static GlyphCache instance;
+	return instance;
+}
+
+GlyphCache::Glyph GlyphCache::render(TTF_Font* font, Uint32 c)
+{
+	// Encode as UTF-8, TTF lays out a lone glyph like it would in a string
+	char s[5] = { 0 };
+	if (c < 0x80) {
+		s[0] = (char)c;
+	} else if (c < 0x800) {
+		s[0] = (char)(0xC0 | (c >> 6));
+		s[1] = (char)(0x80 | (c & 0x3F));
+	} else if (c < 0x10000) {
+		s[0] = (char)(0xE0 | (c >> 12));
+		s[1] = (char)(0x80 | ((c >> 6) & 0x3F));
+		s[2] = (char)(0x80 | (c & 0x3F));
+	} else {
+		s[0] = (char)(0xF0 | (c >> 18));
+		s[1] = (char)(0x80 | ((c >> 12) & 0x3F));
+		s[2] = (char)(0x80 | ((c >> 6) & 0x3F));
+		s[3] = (char)(0x80 | (c & 0x3F));
+	}
+
+	Glyph g = { { 0, 0, 0, 0 }, 0, 0 };
+	int minx = 0, maxx, miny, maxy;
+	if (c > 0xFFFF || TTF_GlyphMetrics(font, (Uint16)c, &minx, &maxx, &miny, &maxy, &g.advance) < 0)
+		TTF_SizeUTF8(font, s, &g.advance, nullptr);
+	g.x = std::min(minx, 0);
+
+	// White coverage, tinted per vertex when drawn; blanks have no pixels
+	SDL_Surface* surf = TTF_RenderUTF8_Blended(font, s, { 0xFF, 0xFF, 0xFF, 0xFF });
+	if (surf) {
+		SpriteAtlas::get_instance().put(&g.src, surf);
+		g.src.w = surf->w;
+		g.src.h = surf->h;
+		SDL_FreeSurface(surf);
+	}
+	return g;
+}
+
+int GlyphCache::get_kerning(TTF_Font* font, Uint32 prev, Uint32 c)
+{
+	if (prev > 0xFFFF || c > 0xFFFF)
+		return 0;
+	return TTF_GetFontKerningSizeGlyphs(font, (Uint16)prev, (Uint16)c);
+}
+
+GlyphCache::Glyph GlyphCache::get(TTF_Font* font, Uint32 c)
+{
+	lock_guard<mutex> lk(_mut);
+	auto& glyphs = _fonts[font];
+	auto it = glyphs.find(c);
+	if (it == glyphs.end())
+		it = glyphs.emplace(c, render(font, c)).first;
+	return it->second;
+}
+
+void GlyphCache::clear()
+{
+	lock_guard<mutex> lk(_mut);
+	_fonts.clear();
+}
\ No newline at end of file
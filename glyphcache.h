@@ -0,0 +1,32 @@
+#pragma once
+#include <unordered_map>
+#include <mutex>
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+/* Glyphs rasterised once per font into the UI atlas, strings are then
+ * laid out & drawn as one quad per glyph without rendering anything */
+class GlyphCache {
+public:
+	struct Glyph {
+		SDL_Rect src;
+		int x;
+		int advance;
+	};
+
+private:
+	std::unordered_map<TTF_Font*, std::unordered_map<Uint32, Glyph>> _fonts;
+	mutable std::mutex _mut;
+
+	GlyphCache() = default;
+	static Glyph render(TTF_Font*, Uint32);
+public:
+	GlyphCache(const GlyphCache&) = delete;
+	GlyphCache& operator=(const GlyphCache&) = delete;
+
+	static GlyphCache& get_instance();
+	static int get_kerning(TTF_Font*, Uint32, Uint32);
+
+	Glyph get(TTF_Font*, Uint32);
+	void clear();
+};
\ No newline at end of file
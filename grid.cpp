@@ -0,0 +1,344 @@
+#include <algorithm>
+#include "thumbcache.h"
+#include "scheduler.h"
+#include "render.h"
+#include "grid.h"
+
+using namespace std;
+
+Grid::Grid(const vector<shared_ptr<Page>>& pages, function<void()>&& notify)
+	: _pages(pages)
+	, _notify(move(notify))
+	, _cells(pages.size(), { EMPTY, 0, 0 })
+	, _view({ 0, 0, 0, 0 })
+	, _current(0)
+	, _cols(1)
+	, _scroll(0)
+	, _first(-1)
+	, _last(-1)
+{
+	// One atlas holds as many thumbnails as the renderer allows, up to
+	// 2048px square; zero means no limit
+	int maxw, maxh;
+	RenderWindow::get_instance().get_max_texture_size(&maxw, &maxh);
+	_atlassize = 2048;
+	if (maxw)
+		_atlassize = std::min(_atlassize, maxw);
+	if (maxh)
+		_atlassize = std::min(_atlassize, maxh);
+	_atlassize = std::max(_atlassize, ThumbCache::get_size());
+}
+
+Grid::~Grid()
+{
+	clear();
+}
+
+int Grid::get_cell_size() const
+{
+	return ThumbCache::get_size() + _pad;
+}
+
+int Grid::get_rows() const
+{
+	return ((int)_cells.size() + _cols - 1) / _cols;
+}
+
+void Grid::get_keep(int* first, int* last) const
+{
+	// Rows within a screen's height of the visible ones keep their slots
+	int margin = _last - _first + 1;
+	*first = _first - margin;
+	*last = _last + margin;
+}
+
+int Grid::get_distance(int row) const
+{
+	// Rows away from the visible ones, zero when visible
+	return (row < _first ? _first - row : std::max(row - _last, 0));
+}
+
+SDL_Rect Grid::get_slot(int slot) const
+{
+	int size = ThumbCache::get_size();
+	int side = _atlassize / size;
+	int k = slot % (side * side);
+	return { (k % side) * size, (k / side) * size, size, size };
+}
+
+int Grid::acquire_slot(int row)
+{
+	// Add an atlas while under the limit
+	if (_free.empty() && (int)_atlases.size() < _maxatlases) {
+		SDL_Texture* t = SDL_CreateTexture(
+			RenderWindow::get_instance().get_renderer(),
+			SDL_PIXELFORMAT_ARGB8888,
+			SDL_TEXTUREACCESS_STATIC,
+			_atlassize,
+			_atlassize
+		);
+		if (t) {
+			int side = _atlassize / ThumbCache::get_size();
+			int base = (int)_owners.size();
+			_atlases.push_back(t);
+			_owners.resize(base + side * side);
+			for (int k = side * side; k-- > 0;)
+				_free.push_back(base + k);
+		}
+	}
+
+	if (!_free.empty()) {
+		int slot = _free.back();
+		_free.pop_back();
+		return slot;
+	}
+
+	// Otherwise take the slot of the cell furthest from the viewport,
+	// provided it is further away than the row asking
+	int best = -1;
+	int dist = get_distance(row);
+	for (int slot = 0; slot < (int)_owners.size(); ++slot) {
+		int d = get_distance((int)_owners[slot] / _cols);
+		if (d > dist) {
+			dist = d;
+			best = slot;
+		}
+	}
+	if (best >= 0)
+		_cells[_owners[best]].slot = EMPTY;
+	return best;
+}
+
+void Grid::request()
+{
+	int size = get_cell_size();
+	int first = _scroll / size;
+	int last = std::min((_scroll + std::max(_view.h, 1) - 1) / size, get_rows() - 1);
+	if (first == _first && last == _last)
+		return;
+	_first = first;
+	_last = last;
+
+	// Queue afresh, cells of dropped jobs are asked for again
+	Scheduler::get_instance().cancel(Scheduler::OVERVIEW);
+	for (Cell& c : _cells) {
+		if (c.slot == PENDING)
+			c.slot = EMPTY;
+	}
+
+	// Visible rows first, then outwards alternating below & above
+	int r0, r1;
+	get_keep(&r0, &r1);
+	vector<int> rows;
+	for (int r = first; r <= last; ++r)
+		rows.push_back(r);
+	for (int d = 1; first - d >= r0 || last + d <= r1; ++d) {
+		if (last + d <= r1 && last + d < get_rows())
+			rows.push_back(last + d);
+		if (first - d >= r0 && first - d >= 0)
+			rows.push_back(first - d);
+	}
+
+	for (int r : rows) {
+		for (int col = 0; col < _cols; ++col) {
+			size_t i = (size_t)(r * _cols + col);
+			if (i < _cells.size() && _cells[i].slot == EMPTY)
+				submit(i);
+		}
+	}
+}
+
+void Grid::submit(size_t i)
+{
+	_cells[i].slot = PENDING;
+	Scheduler::get_instance().submit(Scheduler::OVERVIEW, [this, i](auto& t) {
+		if (t.stale())
+			return;
+
+		SDL_Surface* thumb = ThumbCache::get_instance().load(*_pages[i]);
+		_ready.push({ i, thumb });
+		_notify();
+	});
+}
+
+void Grid::clamp_scroll()
+{
+	int max = std::max(get_rows() * get_cell_size() - _view.h, 0);
+	_scroll = clamp(_scroll, 0, max);
+}
+
+void Grid::set_viewport(const SDL_Rect& r)
+{
+	_view = r;
+	_cols = std::max(_view.w / get_cell_size(), 1);
+	clamp_scroll();
+
+	// Row numbers changed, keep rows are recomputed
+	_first = _last = -1;
+	request();
+}
+
+void Grid::set_current(size_t i)
+{
+	_current = i;
+}
+
+void Grid::scroll(int dy)
+{
+	_scroll += dy;
+	clamp_scroll();
+	request();
+}
+
+void Grid::scroll_to(size_t i)
+{
+	// Center the page's row
+	int size = get_cell_size();
+	_scroll = (int)i / _cols * size - (_view.h - size) / 2;
+	clamp_scroll();
+	request();
+}
+
+int Grid::get_index(int x, int y) const
+{
+	int size = get_cell_size();
+	int x0 = _view.x + (_view.w - _cols * size) / 2;
+	if (x < x0 || y < _view.y || y >= _view.y + _view.h)
+		return -1;
+
+	int col = (x - x0) / size;
+	int row = (y - _view.y + _scroll) / size;
+	size_t i = (size_t)(row * _cols + col);
+	return (col < _cols && i < _cells.size() ? (int)i : -1);
+}
+
+int Grid::get_row_height() const
+{
+	return get_cell_size();
+}
+
+void Grid::update()
+{
+	// A few thumbnails per frame, the rest follow on the next ones
+	vector<pair<size_t, SDL_Surface*>> ready;
+	pair<size_t, SDL_Surface*> r;
+	while (ready.size() < (size_t)_frameuploads && _ready.pop(r))
+		ready.push_back(r);
+
+	int r0, r1;
+	get_keep(&r0, &r1);
+	int side = _atlassize / ThumbCache::get_size();
+	for (auto& [i, s] : ready) {
+		Cell& c = _cells[i];
+		if (!s) {
+			if (c.slot < 0)
+				c.slot = FAILED;
+			continue;
+		}
+
+		// Drop duplicates & results scrolled far out of view
+		int row = (int)i / _cols;
+		if (c.slot >= 0 || c.slot == FAILED || row < r0 || row > r1) {
+			if (c.slot == PENDING)
+				c.slot = EMPTY;
+			SDL_FreeSurface(s);
+			continue;
+		}
+
+		int slot = acquire_slot(row);
+		if (slot < 0) {
+			c.slot = EMPTY;
+			SDL_FreeSurface(s);
+			continue;
+		}
+
+		SDL_Rect r = get_slot(slot);
+		r.w = s->w;
+		r.h = s->h;
+		SDL_UpdateTexture(_atlases[slot / (side * side)], &r, s->pixels, s->pitch);
+		c = { slot, s->w, s->h };
+		_owners[slot] = i;
+		SDL_FreeSurface(s);
+	}
+
+	// Ask again for visible cells that lost their slot, unless the
+	// viewport alone holds more cells than all atlases together
+	if (ready.empty() || (size_t)(_last - _first + 1) * _cols > (size_t)_maxatlases * side * side)
+		return;
+	for (size_t i = (size_t)_first * _cols; i < _cells.size() && (int)i / _cols <= _last; ++i) {
+		if (_cells[i].slot == EMPTY)
+			submit(i);
+	}
+}
+
+void Grid::draw() const
+{
+	SDL_Renderer* r = RenderWindow::get_instance().get_renderer();
+	SDL_RenderSetClipRect(r, &_view);
+
+	int size = get_cell_size();
+	int thumb = ThumbCache::get_size();
+	int side = _atlassize / thumb;
+	int x0 = _view.x + (_view.w - _cols * size) / 2;
+	int first = _scroll / size;
+	int last = (_scroll + _view.h - 1) / size;
+
+	// Only the visible rows are touched, whatever the page count
+	for (int row = first; row <= last; ++row) {
+		for (int col = 0; col < _cols; ++col) {
+			size_t i = (size_t)(row * _cols + col);
+			if (i >= _cells.size())
+				break;
+
+			const Cell& c = _cells[i];
+			int x = x0 + col * size + _pad / 2;
+			int y = _view.y + row * size - _scroll + _pad / 2;
+
+			SDL_Rect dst = { x, y, thumb, thumb };
+			if (c.slot >= 0) {
+				SDL_Rect src = get_slot(c.slot);
+				src.w = c.w;
+				src.h = c.h;
+				dst = { x + (thumb - c.w) / 2, y + (thumb - c.h) / 2, c.w, c.h };
+				SDL_RenderCopy(r, _atlases[c.slot / (side * side)], &src, &dst);
+			} else {
+				// Placeholder until the thumbnail arrives
+				SDL_SetRenderDrawColor(r, 50, 50, 50, 0xFF);
+				SDL_RenderFillRect(r, &dst);
+			}
+
+			// Outline the current page
+			if (i == _current) {
+				SDL_SetRenderDrawColor(r, 200, 200, 200, 0xFF);
+				for (int k = 2; k <= 3; ++k) {
+					SDL_Rect o = { dst.x - k, dst.y - k, dst.w + 2 * k, dst.h + 2 * k };
+					SDL_RenderDrawRect(r, &o);
+				}
+			}
+		}
+	}
+
+	SDL_RenderSetClipRect(r, nullptr);
+}
+
+bool Grid::is_ready() const
+{
+	return _ready.empty();
+}
+
+void Grid::clear()
+{
+	for (SDL_Texture* t : _atlases)
+		SDL_DestroyTexture(t);
+	_atlases.clear();
+	_owners.clear();
+	_free.clear();
+
+	pair<size_t, SDL_Surface*> r;
+	while (_ready.pop(r))
+		SDL_FreeSurface(r.second);
+
+	for (Cell& c : _cells)
+		c = { EMPTY, 0, 0 };
+	_first = _last = -1;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include <functional>
+#include <utility>
+#include <memory>
+#include <vector>
+#include <SDL.h>
+#include "page.h"
+#include "msgqueue.h"
+
+/* Overview of all pages as a virtualised grid of thumbnails; only cells
+ * in or near the viewport hold a slot in one of a few shared atlas
+ * textures, missing thumbnails are made by low priority jobs with the
+ * visible rows queued first */
+class Grid {
+	struct Cell {
+		int slot;
+		int w;
+		int h;
+	};
+
+	enum { EMPTY = -1, PENDING = -2, FAILED = -3 };
+
+	const std::vector<std::shared_ptr<Page>>& _pages;
+	const std::function<void()> _notify;
+	std::vector<Cell> _cells;
+	std::vector<SDL_Texture*> _atlases;
+	std::vector<size_t> _owners;
+	std::vector<int> _free;
+	MessageQueue<std::pair<size_t, SDL_Surface*>> _ready;
+	SDL_Rect _view;
+	size_t _current;
+	int _atlassize;
+	int _cols;
+	int _scroll;
+	int _first;
+	int _last;
+
+	static const int _pad = 16;
+	static const int _maxatlases = 4;
+	static const int _frameuploads = 32;
+
+	int get_cell_size() const;
+	int get_rows() const;
+	void get_keep(int*, int*) const;
+	int get_distance(int) const;
+	SDL_Rect get_slot(int) const;
+	int acquire_slot(int);
+	void submit(size_t);
+	void request();
+	void clamp_scroll();
+public:
+	Grid(const std::vector<std::shared_ptr<Page>>&, std::function<void()>&&);
+	Grid(const Grid&) = delete;
+	Grid& operator=(const Grid&) = delete;
+	~Grid();
+
+	void set_viewport(const SDL_Rect&);
+	void set_current(size_t);
+	void scroll(int);
+	void scroll_to(size_t);
+	int get_index(int, int) const;
+	int get_row_height() const;
+
+	void update();
+	void draw() const;
+	bool is_ready() const;
+	void clear();
+};
\ No newline at end of file
@@ -1,236 +1,481 @@
 #include <iostream>
 #include <algorithm>
 #include <cstdlib>
-#include <cstring>
 #include <SDL.h>
 #include <SDL_image.h>
 #include "image.h"
+#include "texcache.h"
+#include "thumbcache.h"
+#include "jpeg.h"
+#include "convert.h"
+#include "flip.h"
+#include "rotate.h"
 #include "render.h"
-#include "util.h"
 
 using namespace std;
 namespace fs = std::filesystem;
 
-void Image::load() 
+int Image::get_scale(const Page& p, int vw, int vh)
 {
-	aquire(_mut);
+	// Only JPEGs can be decoded at reduced scale
+	if (!p.is_jpeg() || vw <= 0 || vh <= 0)
+		return 1;
+
+	// Dimensions are known without touching the file once a page was seen
+	int w, h;
+	bool scalable;
+	ThumbCache::Meta m;
+	if (ThumbCache::get_instance().find(p, &m)) {
+		w = m.w;
+		h = m.h;
+		scalable = m.scalable;
+	} else if (!get_header(p, &w, &h, &scalable)) {
+		return 1;
+	}
+	if (!scalable)
+		return 1;
 
-	// Destroy old surface
-	SDL_FreeSurface(_surface);
+	// Scale at which the page fits the viewport
+	return get_scale(std::min({ (float)vw / (float)w, (float)vh / (float)h, 1.f }));
+}
 
-	// Load image into surface
-	_surface = IMG_Load(_path.c_str());
-	if (!_surface) {
-		cerr << "Failed to load surface: " << _path << endl;
-		exit(1);
+bool Image::get_header(const Page& p, int* w, int* h, bool* scalable)
+{
+	// Headers usually fit the leading bytes, saving archives a full inflate;
+	// large metadata segments push them further, then take the whole page
+	Buffer b = p.read_header(_headerbytes);
+	if (Jpeg::get_size(b.data(), b.size(), w, h, scalable))
+		return true;
+	if (b.size() < _headerbytes)
+		return false;
+
+	b = p.read();
+	return Jpeg::get_size(b.data(), b.size(), w, h, scalable);
+}
+
+int Image::get_scale(float zoom)
+{
+	// Largest 1/n reduction that is still >= the displayed size
+	int n = 1;
+	while (n < 8 && zoom * (float)(n * 2) <= 1.f)
+		n *= 2;
+	return n;
+}
+
+string Image::get_key(const Page& p, int scale)
+{
+	return p.get_key() + '|' + to_string(scale);
+}
+
+SDL_Surface* Image::read(const Page& p, int scale, ThumbCache::Meta* meta, const Cancel& cancelled)
+{
+	// Decoders read straight from the page's buffer, released on return
+	Buffer b = p.read();
+	SDL_Surface* s = nullptr;
+	int w = 0, h = 0;
+	bool scalable = false;
+	if (p.is_jpeg() && Jpeg::get_size(b.data(), b.size(), &w, &h, &scalable) && scalable)
+		s = Jpeg::load(b.data(), b.size(), scale, cancelled);
+	if (!s && cancelled && cancelled())
+		return nullptr;
+
+	// Layouts libjpeg can't scale are decoded whole, at any requested scale
+	if (!s && b) {
+		s = IMG_Load_RW(b.get_rwops(), 1);
+		scalable = false;
+	}
+	if (!s)
+		return nullptr;
+	if (!scalable) {
+		w = s->w;
+		h = s->h;
 	}
 
-	// Get dimensions
-	_w = _surface->w;
-	_h = _surface->h;
-	_uflag = true;
+	// Match the renderer's texture format here, making uploads a plain copy
+	Uint32 fmt = RenderWindow::get_instance().get_native_format();
+	if (fmt != SDL_PIXELFORMAT_UNKNOWN) {
+		SDL_Surface* out = Convert::to_format(s, fmt);
+		if (out != s)
+			SDL_FreeSurface(s);
+		s = out;
+	}
+
+	// Report full resolution dimensions & whether scaled decodes work
+	if (meta)
+		*meta = { w, h, s->format->format, scalable };
+	return s;
 }
 
-Image::Image(const fs::path& p)
-	: _path(p.string())
+SurfaceCache::Surface Image::decode(const Page& p, int scale, ThumbCache::Meta* meta, const Cancel& cancelled)
 {
-	if (!Util::is_image(p)) {
-		cerr << "Internal error: " << p << " is not an image" << endl;
-		exit(1);
+	// Meta is only filled in when the page is actually decoded; failed &
+	// cancelled decodes aren't cached, threads waiting on them try themselves
+	return SurfaceCache::get_instance().load(
+		get_key(p, scale),
+		[&p, scale, meta, &cancelled]() { return read(p, scale, meta, cancelled); }
+	);
+}
+
+SDL_Surface* Image::halve(SDL_Surface* src)
+{
+	SDL_Surface* conv = Convert::to_bytes(src, true);
+	if (!conv)
+		return nullptr;
+	if (conv == src)
+		conv = nullptr;
+	else
+		src = conv;
+
+	SDL_PixelFormat* fmt = src->format;
+	int size = fmt->BytesPerPixel;
+	int w = src->w / 2;
+	int h = src->h / 2;
+	SDL_Surface* out = SDL_CreateRGBSurfaceWithFormat(0, w, h, fmt->BitsPerPixel, fmt->format);
+	if (!out) {
+		SDL_FreeSurface(conv);
+		return nullptr;
 	}
 
-	load();
+	// Average each 2x2 block per channel
+	const Uint8* pixels = (const Uint8*)src->pixels;
+	Uint8* npixels = (Uint8*)out->pixels;
+	int pitch = src->pitch;
+
+	for (int y = 0; y < h; ++y) {
+		const Uint8* r0 = pixels + 2 * y * pitch;
+		const Uint8* r1 = r0 + pitch;
+		Uint8* dst = npixels + y * out->pitch;
+		for (int x = 0; x < w * size; x += size) {
+			for (int c = 0; c < size; ++c) {
+				int i = 2 * x + c;
+				dst[x + c] = (Uint8)((r0[i] + r0[i + size] + r1[i] + r1[i + size] + 2) >> 2);
+			}
+		}
+	}
+
+	SDL_FreeSurface(conv);
+	return out;
 }
 
-void Image::reset() 
+vector<SurfaceCache::Surface> Image::decode_levels(const Page& p, int scale, const Cancel& cancelled)
 {
-	load();
+	vector<SurfaceCache::Surface> levels;
+	ThumbCache::Meta meta = { 0, 0, 0, false };
+	SurfaceCache::Surface base = decode(p, scale, &meta, cancelled);
+	if (!base)
+		return levels;
+	SurfaceCache::Surface prev = base;
+
+	// Each level halves the previous one until it gets too small
+	string key = get_key(p, scale);
+	for (int n = 1; _mipmaps && prev->w / 2 >= _minlevel && prev->h / 2 >= _minlevel; ++n) {
+		SDL_Surface* src = prev.get();
+		prev = SurfaceCache::get_instance().load(
+			key + '|' + to_string(n),
+			[src]() { return halve(src); }
+		);
+		if (!prev)
+			break;
+		levels.push_back(prev);
+	}
+
+	// Persist dimensions & a preview taken from the smallest level, once per
+	// page; pages taken from the surface cache leave that to the overview
+	ThumbCache& tc = ThumbCache::get_instance();
+	ThumbCache::Meta m;
+	if (meta.w && !tc.find(p, &m))
+		tc.put(p, meta, (levels.empty() ? base : levels.back()).get());
+
+	return levels;
 }
 
-void Image::draw(const SDL_Rect& dst) const
+void Image::clear_levels()
 {
-	aquire(_mut);
-	RenderWindow::get_instance().render(_texture, &dst);
+	// Level textures may be freed off the render thread
+	for (Tiles& t : _ltiles) {
+		if (!t.empty())
+			TextureCache::get_instance().release(move(t));
+	}
+	_ltiles.clear();
+	_levels.clear();
 }
 
-void Image::get_size(int *w, int *h) const
+bool Image::load(const Cancel& cancelled)
 {
-	aquire(_mut);
-	if (w) *w = _w;
-	if (h) *h = _h;
+	// Mipmap levels first, recording the page's dimensions & preview when
+	// this decodes it, then the base surface; usually both are cached
+	vector<SurfaceCache::Surface> levels = decode_levels(*_page, _scale, cancelled);
+
+	// Share decoded surface with the cache, unreadable pages keep the
+	// image as it is
+	ThumbCache::Meta m = { 0, 0, 0, false };
+	SurfaceCache::Surface s = decode(*_page, _scale, &m, cancelled);
+	if (!s)
+		return false;
+	set_surface(s.get());
+	_source = move(s);
+	_key = get_key(*_page, _scale);
+	_pristine = true;
+	_applied.reset();
+
+	clear_levels();
+	_levels = move(levels);
+	_ltiles.resize(_levels.size());
+
+	// Report full resolution dimensions, known from the decode or recorded
+	// by an earlier one
+	_w = _surface->w;
+	_h = _surface->h;
+	if (_scale > 1 && (m.w || ThumbCache::get_instance().find(*_page, &m))) {
+		_w = m.w;
+		_h = m.h;
+	} else if (_scale > 1) {
+		get_header(*_page, &_w, &_h);
+	}
+	return true;
 }
 
-void Image::flip_x()
+void Image::set_surface(SDL_Surface* s)
 {
-	aquire(_mut);
+	// Cached surface is shared, only free private copies
+	if (_surface != _source.get())
+		SDL_FreeSurface(_surface);
+	_surface = s;
+	_pristine = false;
+	_uflag = true;
 
-	// Get pixel format
-	SDL_PixelFormat* fmt = _surface->format;
+	// Levels no longer match the surface
+	clear_levels();
+}
 
-	// Create new surface w/ identical dimensions
-	SDL_Surface *out = SDL_CreateRGBSurface(
-		0,
-		_w,
-		_h,
-		fmt->BitsPerPixel,
-		fmt->Rmask,
-		fmt->Gmask,
-		fmt->Bmask,
-		fmt->Amask
-	);
+Image::Image(shared_ptr<const Page> p, int scale)
+	: _page(move(p))
+	, _pristine(false)
+	, _scale(scale)
+{}
 
-	// Lock both surfaces
-	if (SDL_LockSurface(_surface) < 0 || SDL_LockSurface(out) < 0) {
-		cerr << "Failed to lock surface: " << SDL_GetError() << endl;
-		exit(1);
+unique_ptr<Image> Image::open(shared_ptr<const Page> p, int scale, const Cancel& cancelled)
+{
+	// Unreadable pages & cancelled decodes give no image
+	unique_ptr<Image> img(new Image(move(p), scale));
+	if (!img->load(cancelled))
+		return nullptr;
+	return img;
+}
+
+Image::~Image()
+{
+	// Hand untransformed, up-to-date textures to the cache
+	TextureCache& tc = TextureCache::get_instance();
+	if (!_tiles.empty()) {
+		if (_pristine && !_uflag && _tiles.ready())
+			tc.put(_key, move(_tiles));
+		else
+			tc.release(move(_tiles));
 	}
 
-	// Iterate over rows, copying pixels
-	Uint8* pixels = (Uint8*)_surface->pixels;
-	Uint8* npixels = (Uint8*)out->pixels;
-	int pitch = _surface->pitch;
+	// Levels only exist while untransformed
+	for (size_t n = 0; n < _ltiles.size(); ++n) {
+		if (!_ltiles[n].empty())
+			tc.put(_key + '|' + to_string(n + 1), move(_ltiles[n]));
+	}
 
-	for (int y = 0; y < _h; ++y) {
-		memcpy(
-			npixels + y * pitch,
-			pixels + (_h - y - 1) * pitch,
-			pitch
-		);
+	// Leave freeing of the shared surface to the cache
+	if (_surface == _source.get())
+		_surface = nullptr;
+}
+
+void Image::update()
+{
+	// Software renderers would turn the page on the CPU every frame
+	if (_applied != _orient && RenderWindow::get_instance().is_software())
+		bake();
+
+	if (!_uflag)
+		return;
+	_uflag = false;
+
+	// Re-use the textures of a recently viewed page
+	if (_pristine) {
+		Tiles t = TextureCache::get_instance().take(_key);
+		if (!t.empty()) {
+			_tiles = move(t);
+			return;
+		}
 	}
 
-	// Unlock surfaces
-	SDL_UnlockSurface(_surface);
-	SDL_UnlockSurface(out);
+	// Split into tiles if larger than the renderer allows, pixels
+	// are uploaded over the following frames
+	_tiles.begin(_surface);
+}
 
-	// Swap & free old surface
-	SDL_FreeSurface(_surface);
-	_surface = out;
-	_uflag = true;
+void Image::reset() 
+{
+	_orient.reset();
 }
 
-void Image::flip_y()
+void Image::bake()
 {
-	aquire(_mut);
+	// Start over from the decoded pixels
+	if (!_applied.is_identity())
+		load();
+
+	// Turn first so mirroring works in place on the turned copy, a turn
+	// after a mirror is the opposite turn before it & turning twice is
+	// mirroring both ways
+	int turns = _orient.get_turns();
+	bool flip = _orient.is_flipped();
+	if (turns & 1)
+		rotate_surface((turns == 1) != flip);
+	if (flip != (turns == 2))
+		flip_surface_y();
+	if (turns == 2)
+		flip_surface_x();
+
+	_applied = _orient;
+}
 
-	// Get pixel format
-	SDL_PixelFormat* fmt = _surface->format;
-	int size = fmt->BytesPerPixel;
+int Image::get_scale() const
+{
+	return _scale;
+}
 
-	// Create new surface w/ identical dimensions
-	SDL_Surface *out = SDL_CreateRGBSurface(
-		0,
-		_w,
-		_h,
-		fmt->BitsPerPixel,
-		fmt->Rmask,
-		fmt->Gmask,
-		fmt->Bmask,
-		fmt->Amask
-	);
+const Orientation& Image::get_orientation() const
+{
+	return _orient;
+}
 
-	// Lock both surfaces
-	if (SDL_LockSurface(_surface) < 0 || SDL_LockSurface(out) < 0) {
-		cerr << "Failed to lock surface: " << SDL_GetError() << endl;
-		exit(1);
+void Image::set_orientation(const Orientation& o)
+{
+	// Pixels are re-baked on the next update where needed
+	_orient = o;
+}
+
+void Image::draw(const SDL_Rect& dst) const
+{
+	// Orientation not baked into the pixels is left to the renderer
+	Orientation o = (_applied.is_identity() ? _orient : Orientation());
+
+	// Continue uploading the base texture
+	_tiles.step(dst, o);
+
+	// Pick the smallest level still covering the destination
+	int w = dst.w;
+	int h = dst.h;
+	o.get_size(&w, &h);
+
+	size_t n = 0;
+	while (n < _levels.size() && _levels[n]->w >= w && _levels[n]->h >= h)
+		++n;
+
+	if (!n) {
+		_tiles.draw(dst, o);
+		return;
 	}
 
-	// Iterate over columns, copying pixels
-	Uint8* pixels = (Uint8*)_surface->pixels;
-	Uint8* npixels = (Uint8*)out->pixels;
-	int pitch = _surface->pitch;
-
-	for (int y = 0; y < _h; ++y) {
-		int row = y * pitch;
-		for (int x = 0; x < _w; ++x) {
-			memcpy(
-				npixels + x * size + row,
-				pixels + (_w - x - 1) * size + row,
-				size
-			);
-		}
+	// Upload level on first use
+	Tiles& t = _ltiles[n - 1];
+	if (t.empty()) {
+		t = TextureCache::get_instance().take(_key + '|' + to_string(n));
+		if (t.empty())
+			t.upload(_levels[n - 1].get());
 	}
 
-	// Unlock surfaces
-	SDL_UnlockSurface(_surface);
-	SDL_UnlockSurface(out);
+	t.draw(dst, o);
+}
 
-	// Swap & free old surface
-	SDL_FreeSurface(_surface);
-	_surface = out;
-	_uflag = true;
+void Image::get_size(int *w, int *h) const
+{
+	int ow = _w;
+	int oh = _h;
+	_orient.get_size(&ow, &oh);
+	if (w) *w = ow;
+	if (h) *h = oh;
+}
+
+bool Image::is_ready() const
+{
+	return !_uflag && _tiles.ready();
+}
+
+void Image::flip_x()
+{
+	_orient.flip_x();
+}
+
+void Image::flip_y()
+{
+	_orient.flip_y();
 }
 
 void Image::rotate_cw()
 {
-	aquire(_mut);
+	_orient.rotate_cw();
+}
 
-	// Get pixel format
-	SDL_PixelFormat* fmt = _surface->format;
-	int size = fmt->BytesPerPixel;
+void Image::rotate_ccw()
+{
+	_orient.rotate_ccw();
+}
 
-	// Create new surface w/ flipped dimensions
-	SDL_Surface *out = SDL_CreateRGBSurface(
-		0,
-		_h,
-		_w,
-		fmt->BitsPerPixel,
-		fmt->Rmask,
-		fmt->Gmask,
-		fmt->Bmask,
-		fmt->Amask
-	);
+void Image::unshare()
+{
+	// Copy on write, the decoded surface belongs to the cache
+	if (_surface != _source.get())
+		return;
 
-	// Lock both surfaces
-	if (SDL_LockSurface(_surface) < 0 || SDL_LockSurface(out) < 0) {
-		cerr << "Failed to lock surface: " << SDL_GetError() << endl;
+	SDL_Surface* s = SDL_DuplicateSurface(_surface);
+	if (!s) {
+		cerr << "Failed to copy surface: " << SDL_GetError() << endl;
 		exit(1);
 	}
+	set_surface(s);
+}
 
-	// Per-pixel copy
-	Uint8* pixels = (Uint8*)_surface->pixels;
-	Uint8* npixels = (Uint8*)out->pixels;
-	int pitch = _surface->pitch;
-	int npitch = out->pitch;
-
-	for (int y = 0; y < _h; ++y) {
-		for (int x = 0; x < _w; ++x) {
-
-			// Translation: _surface(x, y) -> out(h - y, x)
-			memcpy(
-				npixels + (_h - y - 1) * size + x * npitch,
-				pixels + x * size + y * pitch,
-				size
-			);
-		}
+void Image::flip_surface_x()
+{
+	unshare();
+	if (SDL_LockSurface(_surface) < 0) {
+		cerr << "Failed to lock surface: " << SDL_GetError() << endl;
+		exit(1);
 	}
 
-	// Unlock surfaces
+	// Swap rows in place
+	Flip::rows(_surface);
+
 	SDL_UnlockSurface(_surface);
-	SDL_UnlockSurface(out);
+	_uflag = true;
+}
 
-	// Swap & free old surface
-	SDL_FreeSurface(_surface);
-	_surface = out;
+void Image::flip_surface_y()
+{
+	unshare();
+	if (SDL_LockSurface(_surface) < 0) {
+		cerr << "Failed to lock surface: " << SDL_GetError() << endl;
+		exit(1);
+	}
 
-	// Update dimensions
-	_w = _surface->w;
-	_h = _surface->h;
+	// Reverse pixels within rows in place
+	Flip::columns(_surface);
+
+	SDL_UnlockSurface(_surface);
 	_uflag = true;
 }
 
-void Image::rotate_ccw() 
+void Image::rotate_surface(bool cw)
 {
-	aquire(_mut);
+	// Get surface dimensions
+	int w = _surface->w;
+	int h = _surface->h;
 
 	// Get pixel format
 	SDL_PixelFormat* fmt = _surface->format;
-	int size = fmt->BytesPerPixel;
 
 	// Create new surface w/ flipped dimensions
 	SDL_Surface *out = SDL_CreateRGBSurface(
 		0,
-		_h,
-		_w,
+		h,
+		w,
 		fmt->BitsPerPixel,
 		fmt->Rmask,
 		fmt->Gmask,
@@ -244,34 +489,14 @@ void Image::rotate_ccw()
 		exit(1);
 	}
 
-	// Per-pixel copy
-	Uint8* pixels = (Uint8*)_surface->pixels;
-	Uint8* npixels = (Uint8*)out->pixels;
-	int pitch = _surface->pitch;
-	int npitch = out->pitch;
-
-	for (int y = 0; y < _h; ++y) {
-		for (int x = 0; x < _w; ++x) {
-
-			// Translation: _surface(x, y) -> out(y, w - x)
-			memcpy(
-				npixels + y * size + (_w - x - 1) * npitch,
-				pixels + x * size + y * pitch,
-				size
-			);
-		}
-	}
+	// Tiled transpose, translation: _surface(x, y) -> out(h - y, x) when
+	// turning clockwise, out(y, w - x) otherwise
+	Rotate::rotate(_surface, out, cw);
 
 	// Unlock surfaces
 	SDL_UnlockSurface(_surface);
 	SDL_UnlockSurface(out);
 
 	// Swap & free old surface
-	SDL_FreeSurface(_surface);
-	_surface = out;
-
-	// Update dimensions
-	_w = _surface->w;
-	_h = _surface->h;
-	_uflag = true;
+	set_surface(out);
 }
\ No newline at end of file
@@ -1,22 +1,70 @@
 #pragma once
-#include <filesystem>
+#include <memory>
 #include <string>
-#include <mutex>
+#include <vector>
+#include <functional>
 #include "drawable.h"
+#include "surfcache.h"
+#include "thumbcache.h"
+#include "tiles.h"
+#include "page.h"
+#include "orient.h"
 
 class Image : public Drawable {
-	const std::string _path;
-	mutable std::recursive_mutex _mut;
+public:
+	using Cancel = std::function<bool()>;
+
+private:
+	const std::shared_ptr<const Page> _page;
+	std::string _key;
+	SurfaceCache::Surface _source;
+	std::vector<SurfaceCache::Surface> _levels;
+	mutable std::vector<Tiles> _ltiles;
+	mutable Tiles _tiles;
+	Orientation _orient;
+	Orientation _applied;
+	bool _pristine;
+	int _scale;
 	int _w;
 	int _h;
 
-	void load();
+	static const bool _mipmaps = true;
+	static const int _minlevel = 64;
+	static constexpr size_t _headerbytes = 64 << 10;
+
+	Image(std::shared_ptr<const Page>, int);
+	bool load(const Cancel& = nullptr);
+	void set_surface(SDL_Surface*);
+	void clear_levels();
+	void bake();
+	void unshare();
+	void flip_surface_x();
+	void flip_surface_y();
+	void rotate_surface(bool);
+	static SDL_Surface* halve(SDL_Surface*);
+	static bool get_header(const Page&, int*, int*, bool* = nullptr);
 public:
-	Image(const std::filesystem::path&);
+	~Image();
+
+	static std::unique_ptr<Image> open(std::shared_ptr<const Page>, int = 1, const Cancel& = nullptr);
+
+	static int get_scale(const Page&, int, int);
+	static int get_scale(float);
+	static std::string get_key(const Page&, int);
+	static SDL_Surface* read(const Page&, int, ThumbCache::Meta* = nullptr, const Cancel& = nullptr);
+	static SurfaceCache::Surface decode(const Page&, int, ThumbCache::Meta* = nullptr, const Cancel& = nullptr);
+	static std::vector<SurfaceCache::Surface> decode_levels(const Page&, int, const Cancel& = nullptr);
+
+	void update() override;
 
 	void reset();
 	void draw(const SDL_Rect&) const;
 	void get_size(int*, int*) const;
+	bool is_ready() const;
+
+	int get_scale() const;
+	const Orientation& get_orientation() const;
+	void set_orientation(const Orientation&);
 
 	void flip_x();
 	void flip_y();
@@ -0,0 +1,129 @@
+#include <csetjmp>
+#include <cstdio>
+#include <cstddef>
+#include <jpeglib.h>
+#include "jpeg.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+/* libjpeg reports fatal errors through a callback that must not
+ * return, unwind back to the caller with longjmp instead */
+struct ErrorManager {
+	jpeg_error_mgr pub;
+	jmp_buf jmp;
+};
+
+static void on_error(j_common_ptr c)
+{
+	longjmp(((ErrorManager*)c->err)->jmp, 1);
+}
+
+static void on_message(j_common_ptr)
+{}
+
+static bool is_supported(const jpeg_decompress_struct& c)
+{
+	// libjpeg can't convert CMYK/YCCK to RGB, leave those to SDL_image
+	return c.jpeg_color_space != JCS_CMYK && c.jpeg_color_space != JCS_YCCK;
+}
+
+bool Jpeg::is_jpeg(const fs::path& p)
+{
+	string ext = p.extension().string();
+	return !ext.compare(".jpeg") || !ext.compare(".jpg");
+}
+
+bool Jpeg::get_size(const Uint8* data, size_t size, int* w, int* h, bool* scalable)
+{
+	if (!data)
+		return false;
+
+	jpeg_decompress_struct cinfo;
+	ErrorManager err;
+	cinfo.err = jpeg_std_error(&err.pub);
+	err.pub.error_exit = on_error;
+	err.pub.output_message = on_message;
+
+	if (setjmp(err.jmp)) {
+		jpeg_destroy_decompress(&cinfo);
+		return false;
+	}
+
+	// Only the header is read
+	jpeg_create_decompress(&cinfo);
+	jpeg_mem_src(&cinfo, (unsigned char*)data, (unsigned long)size);
+	jpeg_read_header(&cinfo, TRUE);
+
+	// Only layouts load() handles can be decoded at reduced scale
+	if (scalable) *scalable = is_supported(cinfo);
+	if (w) *w = (int)cinfo.image_width;
+	if (h) *h = (int)cinfo.image_height;
+
+	jpeg_destroy_decompress(&cinfo);
+	return true;
+}
+
+SDL_Surface* Jpeg::load(const Uint8* data, size_t size, int scale, const function<bool()>& cancelled)
+{
+	if (!data)
+		return nullptr;
+
+	jpeg_decompress_struct cinfo;
+	ErrorManager err;
+	SDL_Surface* volatile surf = nullptr;
+	cinfo.err = jpeg_std_error(&err.pub);
+	err.pub.error_exit = on_error;
+	err.pub.output_message = on_message;
+
+	if (setjmp(err.jmp)) {
+		jpeg_destroy_decompress(&cinfo);
+		SDL_FreeSurface(surf);
+		return nullptr;
+	}
+
+	jpeg_create_decompress(&cinfo);
+	jpeg_mem_src(&cinfo, (unsigned char*)data, (unsigned long)size);
+	jpeg_read_header(&cinfo, TRUE);
+
+	if (!is_supported(cinfo)) {
+		jpeg_destroy_decompress(&cinfo);
+		return nullptr;
+	}
+
+	// Let the IDCT produce a 1/2, 1/4 or 1/8 scale image directly
+	cinfo.out_color_space = JCS_RGB;
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = scale;
+	jpeg_start_decompress(&cinfo);
+
+	surf = SDL_CreateRGBSurfaceWithFormat(
+		0,
+		cinfo.output_width,
+		cinfo.output_height,
+		24,
+		SDL_PIXELFORMAT_RGB24
+	);
+	if (!surf) {
+		jpeg_destroy_decompress(&cinfo);
+		return nullptr;
+	}
+
+	// Decode straight into the surface rows, giving up between batches
+	// once the result is no longer wanted
+	Uint8* pixels = (Uint8*)surf->pixels;
+	while (cinfo.output_scanline < cinfo.output_height) {
+		if (cancelled && cinfo.output_scanline % _batch == 0 && cancelled()) {
+			jpeg_destroy_decompress(&cinfo);
+			SDL_FreeSurface(surf);
+			return nullptr;
+		}
+
+		JSAMPROW row = pixels + cinfo.output_scanline * surf->pitch;
+		jpeg_read_scanlines(&cinfo, &row, 1);
+	}
+
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+	return surf;
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <SDL.h>
+
+class Jpeg {
+	static constexpr unsigned _batch = 64;
+public:
+	static bool is_jpeg(const std::filesystem::path&);
+	static bool get_size(const Uint8*, size_t, int*, int*, bool* = nullptr);
+	static SDL_Surface* load(const Uint8*, size_t, int, const std::function<bool()>& = nullptr);
+};
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include <utility>
+#include "mapped.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+#ifdef _WIN32
+MappedFile::MappedFile(const fs::path& p, bool sequential)
+	: _data(nullptr)
+	, _size(0)
+	, _file(INVALID_HANDLE_VALUE)
+	, _mapping(nullptr)
+{
+	_file = CreateFileW(
+		p.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		NULL,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | (sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS),
+		NULL
+	);
+	if (_file == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(_file, &size) || !size.QuadPart)
+		return;
+
+	_mapping = CreateFileMappingW(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!_mapping)
+		return;
+
+	_data = (const Uint8*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (_data)
+		_size = (size_t)size.QuadPart;
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+	: _data(exchange(other._data, nullptr))
+	, _size(exchange(other._size, 0))
+	, _file(exchange(other._file, INVALID_HANDLE_VALUE))
+	, _mapping(exchange(other._mapping, nullptr))
+{}
+
+MappedFile::~MappedFile()
+{
+	if (_data)
+		UnmapViewOfFile(_data);
+	if (_mapping)
+		CloseHandle(_mapping);
+	if (_file != INVALID_HANDLE_VALUE)
+		CloseHandle(_file);
+}
+#else
+MappedFile::MappedFile(const fs::path& p, bool sequential)
+	: _data(nullptr)
+	, _size(0)
+{
+	int fd = open(p.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size <= 0) {
+		close(fd);
+		return;
+	}
+
+	// Mapping outlives the descriptor
+	void* m = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (m == MAP_FAILED)
+		return;
+
+	// Decoders read front to back, let the kernel read ahead, archives
+	// are read piecewise so leave those to the default policy
+	if (sequential) {
+		madvise(m, (size_t)st.st_size, MADV_SEQUENTIAL);
+		madvise(m, (size_t)st.st_size, MADV_WILLNEED);
+	}
+	_data = (const Uint8*)m;
+	_size = (size_t)st.st_size;
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+	: _data(exchange(other._data, nullptr))
+	, _size(exchange(other._size, 0))
+{}
+
+MappedFile::~MappedFile()
+{
+	if (_data)
+		munmap((void*)_data, _size);
+}
+#endif
+
+const Uint8* MappedFile::data() const
+{
+	return _data;
+}
+
+size_t MappedFile::size() const
+{
+	return _size;
+}
+
+MappedFile::operator bool() const
+{
+	return _data != nullptr;
+}
+
+SDL_RWops* MappedFile::get_rwops() const
+{
+	return SDL_RWFromConstMem(_data, (int)_size);
+}
\ No newline at end of file
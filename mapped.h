@@ -0,0 +1,26 @@
+#pragma once
+#include <filesystem>
+#include <cstddef>
+#include <SDL.h>
+
+/* Read-only memory mapping of a whole file, unmapped on destruction */
+class MappedFile {
+	const Uint8* _data;
+	size_t _size;
+#ifdef _WIN32
+	void* _file;
+	void* _mapping;
+#endif
+public:
+	MappedFile(const std::filesystem::path&, bool = true);
+	MappedFile(MappedFile&&);
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	const Uint8* data() const;
+	size_t size() const;
+	operator bool() const;
+
+	SDL_RWops* get_rwops() const;
+};
\ No newline at end of file
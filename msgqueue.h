@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+/* Unbounded lock-free queue for any number of producer threads & one
+ * consumer. Producers link a node in with a single exchange, the
+ * consumer walks the list from a stub node nobody else touches */
+template <typename T>
+class MessageQueue {
+	struct Node {
+		std::atomic<Node*> next;
+		T value;
+	};
+
+	std::atomic<Node*> _head;
+	Node* _tail;
+public:
+	MessageQueue()
+		: _head(new Node{ { nullptr }, T() })
+		, _tail(_head.load(std::memory_order_relaxed))
+	{}
+
+	MessageQueue(const MessageQueue&) = delete;
+	MessageQueue& operator=(const MessageQueue&) = delete;
+
+	~MessageQueue()
+	{
+		T v;
+		while (pop(v))
+			;
+		delete _tail;
+	}
+
+	// Any thread
+	void push(T&& v)
+	{
+		Node* n = new Node{ { nullptr }, std::move(v) };
+		Node* prev = _head.exchange(n, std::memory_order_acq_rel);
+		prev->next.store(n, std::memory_order_release);
+	}
+
+	// Consumer only; a push still being linked in shows up on the next call
+	bool pop(T& v)
+	{
+		Node* next = _tail->next.load(std::memory_order_acquire);
+		if (!next)
+			return false;
+
+		v = std::move(next->value);
+		delete _tail;
+		_tail = next;
+		return true;
+	}
+
+	// Consumer only
+	bool empty() const
+	{
+		return !_tail->next.load(std::memory_order_acquire);
+	}
+};
\ No newline at end of file
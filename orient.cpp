@@ -0,0 +1,99 @@
+#include <utility>
+#include "orient.h"
+
+using namespace std;
+
+Orientation::Orientation()
+	: _turns(0)
+	, _flip(false)
+{}
+
+void Orientation::rotate_cw()
+{
+	_turns = (_turns + 1) & 3;
+}
+
+void Orientation::rotate_ccw()
+{
+	_turns = (_turns + 3) & 3;
+}
+
+void Orientation::flip_x()
+{
+	// Vertical mirror is a horizontal one turned upside down, mirroring
+	// first reverses the direction of the existing turns
+	_turns = (2 - _turns) & 3;
+	_flip = !_flip;
+}
+
+void Orientation::flip_y()
+{
+	_turns = (4 - _turns) & 3;
+	_flip = !_flip;
+}
+
+void Orientation::reset()
+{
+	_turns = 0;
+	_flip = false;
+}
+
+bool Orientation::operator==(const Orientation& o) const
+{
+	return _turns == o._turns && _flip == o._flip;
+}
+
+bool Orientation::operator!=(const Orientation& o) const
+{
+	return !(*this == o);
+}
+
+bool Orientation::is_identity() const
+{
+	return !_turns && !_flip;
+}
+
+bool Orientation::is_swapped() const
+{
+	return _turns & 1;
+}
+
+bool Orientation::is_flipped() const
+{
+	return _flip;
+}
+
+int Orientation::get_turns() const
+{
+	return _turns;
+}
+
+double Orientation::get_angle() const
+{
+	return 90.0 * _turns;
+}
+
+SDL_RendererFlip Orientation::get_flip() const
+{
+	return _flip ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
+}
+
+void Orientation::get_size(int* w, int* h) const
+{
+	if (is_swapped())
+		swap(*w, *h);
+}
+
+SDL_Rect Orientation::map(const SDL_Rect& r, int w, int h) const
+{
+	// Carry a rect within a w x h plane over to the oriented plane
+	SDL_Rect o = r;
+	if (_flip)
+		o.x = w - o.x - o.w;
+
+	for (int i = 0; i < _turns; ++i) {
+		o = { h - o.y - o.h, o.x, o.h, o.w };
+		swap(w, h);
+	}
+	return o;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+#include <SDL.h>
+
+/* One of the 8 symmetries of a rectangle, a horizontal mirror followed
+ * by a number of clockwise quarter turns, matching the order in which
+ * SDL_RenderCopyEx applies its flip & angle */
+class Orientation {
+	int _turns;
+	bool _flip;
+public:
+	Orientation();
+
+	void rotate_cw();
+	void rotate_ccw();
+	void flip_x();
+	void flip_y();
+	void reset();
+
+	bool operator==(const Orientation&) const;
+	bool operator!=(const Orientation&) const;
+
+	bool is_identity() const;
+	bool is_swapped() const;
+	bool is_flipped() const;
+	int get_turns() const;
+
+	double get_angle() const;
+	SDL_RendererFlip get_flip() const;
+
+	void get_size(int*, int*) const;
+	SDL_Rect map(const SDL_Rect&, int, int) const;
+};
\ No newline at end of file
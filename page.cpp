@@ -0,0 +1,86 @@
+#include <utility>
+#include "mapped.h"
+#include "page.h"
+#include "jpeg.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+Buffer::Buffer()
+	: _data(nullptr)
+	, _size(0)
+{}
+
+Buffer::Buffer(shared_ptr<const void> owner, const Uint8* data, size_t size)
+	: _owner(move(owner))
+	, _data(data)
+	, _size(size)
+{}
+
+const Uint8* Buffer::data() const
+{
+	return _data;
+}
+
+size_t Buffer::size() const
+{
+	return _size;
+}
+
+Buffer::operator bool() const
+{
+	return _data != nullptr;
+}
+
+SDL_RWops* Buffer::get_rwops() const
+{
+	return SDL_RWFromConstMem(_data, (int)_size);
+}
+
+Buffer Page::read_header(size_t) const
+{
+	// At least the first bytes, mapped pages hand out everything for free
+	return read();
+}
+
+bool Page::is_jpeg() const
+{
+	return Jpeg::is_jpeg(get_name());
+}
+
+FilePage::FilePage(const fs::path& p)
+	: _path(p)
+{}
+
+string FilePage::get_name() const
+{
+	return _path.filename().string();
+}
+
+string FilePage::get_key() const
+{
+	// Key on size & modification time as well, so edited files are re-read
+	// A file that cannot be stat'ed cannot be read either, key it on the path
+	error_code ec;
+	auto t = fs::last_write_time(_path, ec);
+	if (ec)
+		return _path.string();
+	auto n = fs::file_size(_path, ec);
+	if (ec)
+		return _path.string();
+	return _path.string() + '|' + to_string(n) + '|' + to_string(t.time_since_epoch().count());
+}
+
+Buffer FilePage::read() const
+{
+	// Decoders read straight from the mapping, unmapped with the last buffer
+	auto m = make_shared<MappedFile>(_path);
+	if (!*m)
+		return Buffer();
+	return Buffer(m, m->data(), m->size());
+}
+
+const fs::path& FilePage::get_path() const
+{
+	return _path;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <SDL.h>
+
+/* View of a page's encoded bytes, kept valid by a shared owner
+ * (a file mapping, an archive or an inflated copy) */
+class Buffer {
+	std::shared_ptr<const void> _owner;
+	const Uint8* _data;
+	size_t _size;
+public:
+	Buffer();
+	Buffer(std::shared_ptr<const void>, const Uint8*, size_t);
+
+	const Uint8* data() const;
+	size_t size() const;
+	operator bool() const;
+
+	SDL_RWops* get_rwops() const;
+};
+
+/* A single image, either a loose file or an archive member */
+class Page {
+public:
+	virtual ~Page() = default;
+
+	virtual std::string get_name() const = 0;
+	virtual std::string get_key() const = 0;
+	virtual Buffer read() const = 0;
+	virtual Buffer read_header(size_t) const;
+
+	bool is_jpeg() const;
+};
+
+class FilePage final : public Page {
+	const std::filesystem::path _path;
+public:
+	FilePage(const std::filesystem::path&);
+
+	std::string get_name() const override;
+	std::string get_key() const override;
+	Buffer read() const override;
+
+	const std::filesystem::path& get_path() const;
+};
\ No newline at end of file
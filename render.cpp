@@ -2,6 +2,7 @@
 #include <filesystem>
 #include <cstdlib>
 #include <SDL_image.h>
+#include "convert.h"
 #include "render.h"
 #include "util.h"
 
@@ -56,6 +57,12 @@ RenderWindow::RenderWindow()
 		cerr << "Failed to create SDL_Renderer: " << SDL_GetError() << endl;
 		exit(1);
 	}
+
+	// Query renderer capabilities
+	if (SDL_GetRendererInfo(_renderer, &_info) < 0) {
+		cerr << "Failed to query SDL_Renderer: " << SDL_GetError() << endl;
+		exit(1);
+	}
 }
 
 RenderWindow::~RenderWindow() 
@@ -77,6 +84,26 @@ void RenderWindow::render(SDL_Texture *tex, const SDL_Rect *src, const SDL_Rect
 	SDL_RenderCopy(_renderer, tex, src, dst);
 }
 
+void RenderWindow::render(SDL_Texture *tex, const SDL_Rect *src, const SDL_Rect *dst, const Orientation& o) const
+{
+	if (o.is_identity()) {
+		SDL_RenderCopy(_renderer, tex, src, dst);
+		return;
+	}
+
+	// dst is where the texture lands once turned, SDL wants the rect
+	// it is turned from, sharing the center
+	float w = (float)(o.is_swapped() ? dst->h : dst->w);
+	float h = (float)(o.is_swapped() ? dst->w : dst->h);
+	SDL_FRect r = {
+		(float)dst->x + ((float)dst->w - w) / 2.f,
+		(float)dst->y + ((float)dst->h - h) / 2.f,
+		w,
+		h
+	};
+	SDL_RenderCopyExF(_renderer, tex, src, &r, o.get_angle(), nullptr, o.get_flip());
+}
+
 void RenderWindow::clear(Uint8 r = 0xFF, Uint8 g = 0xFF, Uint8 b = 0xFF) const
 {
 	SDL_SetRenderDrawColor(_renderer, r, g, b, 0xFF);
@@ -99,11 +126,48 @@ SDL_Renderer* RenderWindow::get_renderer() const
 	return _renderer;
 }
 
+const SDL_RendererInfo& RenderWindow::get_info() const
+{
+	return _info;
+}
+
+void RenderWindow::get_max_texture_size(int *w, int *h) const
+{
+	// Zero means no limit
+	if (w) *w = _info.max_texture_width;
+	if (h) *h = _info.max_texture_height;
+}
+
+Uint32 RenderWindow::get_native_format() const
+{
+	// First texture format we have a fast conversion for
+	for (Uint32 i = 0; i < _info.num_texture_formats; ++i) {
+		if (Convert::is_supported(_info.texture_formats[i]))
+			return _info.texture_formats[i];
+	}
+	return SDL_PIXELFORMAT_UNKNOWN;
+}
+
+bool RenderWindow::is_software() const
+{
+	return _info.flags & SDL_RENDERER_SOFTWARE;
+}
+
 void RenderWindow::get_size(int *w, int *h) const
 {
 	SDL_GetWindowSize(_window, w, h);
 }
 
+int RenderWindow::get_refresh_rate() const
+{
+	// Of the display the window is mostly on, 0 if unknown
+	SDL_DisplayMode mode;
+	int i = SDL_GetWindowDisplayIndex(_window);
+	if (i < 0 || SDL_GetCurrentDisplayMode(i, &mode) < 0)
+		return 0;
+	return mode.refresh_rate;
+}
+
 void RenderWindow::get_position(int *x, int *y) const
 {
 	SDL_GetWindowPosition(_window, x, y);
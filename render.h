@@ -1,13 +1,15 @@
 #pragma once
 #include <string>
 #include <SDL.h>
+#include "orient.h"
 
 class RenderWindow {
 	static const Uint32 _winflags = SDL_WINDOW_RESIZABLE | SDL_WINDOW_MAXIMIZED;
-	static const Uint32 _renflags = SDL_RENDERER_ACCELERATED;
+	static const Uint32 _renflags = SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC;
 	SDL_Window* _window;
 	SDL_Renderer* _renderer;
 	SDL_Surface* _icon;
+	SDL_RendererInfo _info;
 
 	RenderWindow();
 public:
@@ -17,11 +19,17 @@ public:
 
 	void render(SDL_Texture*, const SDL_Rect*) const;
 	void render(SDL_Texture*, const SDL_Rect*, const SDL_Rect*) const;
+	void render(SDL_Texture*, const SDL_Rect*, const SDL_Rect*, const Orientation&) const;
 	void clear(Uint8, Uint8, Uint8) const;
 	void display() const;
 
 	static RenderWindow& get_instance();
 	SDL_Renderer* get_renderer() const;
+	const SDL_RendererInfo& get_info() const;
+	void get_max_texture_size(int*, int*) const;
+	Uint32 get_native_format() const;
+	bool is_software() const;
+	int get_refresh_rate() const;
 	void get_size(int*, int*) const;
 	void get_position(int*, int*) const;
 
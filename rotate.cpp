@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include "scheduler.h"
+#include "semaphore.h"
+#include "rotate.h"
+#include "simd.h"
+
+using namespace std;
+
+/* Scalar tile kernel, cw maps (x, y) -> (h - 1 - y, x) & ccw (x, y) -> (y, w - 1 - x) */
+template <int N>
+static void rotate_tile(const SDL_Surface* src, SDL_Surface* dst, bool cw, int x0, int x1, int y0, int y1)
+{
+	const Uint8* s = (const Uint8*)src->pixels;
+	Uint8* d = (Uint8*)dst->pixels;
+	int w = src->w;
+	int h = src->h;
+
+	for (int y = y0; y < y1; ++y) {
+		const Pixel<N>* row = (const Pixel<N>*)(s + (size_t)y * src->pitch);
+		for (int x = x0; x < x1; ++x) {
+			int r = cw ? x : w - 1 - x;
+			int c = cw ? h - 1 - y : y;
+			*(Pixel<N>*)(d + (size_t)r * dst->pitch + (size_t)c * N) = row[x];
+		}
+	}
+}
+
+/* Whole blocks of B x B pixels through a transposing kernel, the ragged
+ * right & bottom edges go scalar */
+template <int B, int N, void (*Block)(const Uint8*, int, Uint8*, int, bool)>
+static void rotate_tile_blocks(const SDL_Surface* src, SDL_Surface* dst, bool cw, int x0, int x1, int y0, int y1)
+{
+	const Uint8* s = (const Uint8*)src->pixels;
+	Uint8* d = (Uint8*)dst->pixels;
+	int w = src->w;
+	int h = src->h;
+	int spitch = src->pitch;
+	int dpitch = dst->pitch;
+
+	int xe = x0 + (x1 - x0) / B * B;
+	int ye = y0 + (y1 - y0) / B * B;
+	for (int y = y0; y < ye; y += B) {
+		for (int x = x0; x < xe; x += B) {
+			const Uint8* p = s + (size_t)y * spitch + (size_t)x * N;
+			if (cw)
+				Block(p, spitch, d + (size_t)x * dpitch + (size_t)(h - B - y) * N, dpitch, true);
+			else
+				Block(p, spitch, d + (size_t)(w - 1 - x) * dpitch + (size_t)y * N, -dpitch, false);
+		}
+	}
+	rotate_tile<N>(src, dst, cw, xe, x1, y0, y1);
+	rotate_tile<N>(src, dst, cw, x0, xe, ye, y1);
+}
+
+#ifdef SIMD_X86
+/* Transposes 4 rows of 4 32-bit pixels in registers, rows of the result
+ * are the source columns */
+TARGET_SSE2
+static void transpose_4x4(const __m128i* r, __m128i* c)
+{
+	__m128i t0 = _mm_unpacklo_epi32(r[0], r[1]);
+	__m128i t1 = _mm_unpacklo_epi32(r[2], r[3]);
+	__m128i t2 = _mm_unpackhi_epi32(r[0], r[1]);
+	__m128i t3 = _mm_unpackhi_epi32(r[2], r[3]);
+
+	c[0] = _mm_unpacklo_epi64(t0, t1);
+	c[1] = _mm_unpackhi_epi64(t0, t1);
+	c[2] = _mm_unpacklo_epi64(t2, t3);
+	c[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+/* 4x4 block of 32-bit pixels, columns reversed for clockwise turns */
+TARGET_SSE2
+static void rotate_4x4_sse2(const Uint8* s, int spitch, Uint8* d, int dstep, bool cw)
+{
+	__m128i r[4], c[4];
+	for (int k = 0; k < 4; ++k)
+		r[k] = _mm_loadu_si128((const __m128i*)(s + k * spitch));
+	transpose_4x4(r, c);
+
+	for (int k = 0; k < 4; ++k) {
+		__m128i v = cw ? _mm_shuffle_epi32(c[k], _MM_SHUFFLE(0, 1, 2, 3)) : c[k];
+		_mm_storeu_si128((__m128i*)(d + k * dstep), v);
+	}
+}
+
+/* 4x4 block of 24-bit pixels, widened to 32 bits for the transpose; rows
+ * are read & written as 8 + 4 bytes so nothing past them is touched */
+TARGET_SSSE3
+static void rotate_4x4_ssse3(const Uint8* s, int spitch, Uint8* d, int dstep, bool cw)
+{
+	const __m128i widen = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i narrow = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+	__m128i r[4], c[4];
+	for (int k = 0; k < 4; ++k) {
+		const Uint8* p = s + k * spitch;
+		Uint32 tail;
+		memcpy(&tail, p + 8, 4);
+		__m128i v = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)p), _mm_cvtsi32_si128((int)tail));
+		r[k] = _mm_shuffle_epi8(v, widen);
+	}
+	transpose_4x4(r, c);
+
+	for (int k = 0; k < 4; ++k) {
+		__m128i v = cw ? _mm_shuffle_epi32(c[k], _MM_SHUFFLE(0, 1, 2, 3)) : c[k];
+		v = _mm_shuffle_epi8(v, narrow);
+
+		Uint8* p = d + k * dstep;
+		_mm_storel_epi64((__m128i*)p, v);
+		int tail = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+		memcpy(p + 8, &tail, 4);
+	}
+}
+
+/* 8x8 block of 32-bit pixels, transposed within & then across lanes */
+TARGET_AVX2
+static void rotate_8x8_avx2(const Uint8* s, int spitch, Uint8* d, int dstep, bool cw)
+{
+	__m256i r[8];
+	for (int k = 0; k < 8; ++k)
+		r[k] = _mm256_loadu_si256((const __m256i*)(s + k * spitch));
+
+	__m256i t[8];
+	for (int k = 0; k < 8; k += 2) {
+		t[k] = _mm256_unpacklo_epi32(r[k], r[k + 1]);
+		t[k + 1] = _mm256_unpackhi_epi32(r[k], r[k + 1]);
+	}
+
+	__m256i u[8];
+	for (int k = 0; k < 8; k += 4) {
+		u[k] = _mm256_unpacklo_epi64(t[k], t[k + 2]);
+		u[k + 1] = _mm256_unpackhi_epi64(t[k], t[k + 2]);
+		u[k + 2] = _mm256_unpacklo_epi64(t[k + 1], t[k + 3]);
+		u[k + 3] = _mm256_unpackhi_epi64(t[k + 1], t[k + 3]);
+	}
+
+	const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+	for (int k = 0; k < 4; ++k) {
+		__m256i lo = _mm256_permute2x128_si256(u[k], u[k + 4], 0x20);
+		__m256i hi = _mm256_permute2x128_si256(u[k], u[k + 4], 0x31);
+		if (cw) {
+			lo = _mm256_permutevar8x32_epi32(lo, reverse);
+			hi = _mm256_permutevar8x32_epi32(hi, reverse);
+		}
+		_mm256_storeu_si256((__m256i*)(d + k * dstep), lo);
+		_mm256_storeu_si256((__m256i*)(d + (k + 4) * dstep), hi);
+	}
+}
+#endif
+
+/* Bands shared by the caller & the workers helping out, whoever comes
+ * first takes the next one */
+struct Rotate::Work {
+	vector<Band> bands;
+	atomic_size_t next;
+	Semaphore done;
+};
+
+Rotate::Kernel Rotate::get_kernel(int size, bool simd)
+{
+#if defined(SIMD_X86) && SDL_BYTEORDER == SDL_LIL_ENDIAN
+	static const bool avx2 = SDL_HasAVX2();
+	static const bool sse2 = SDL_HasSSE2();
+	static const bool ssse3 = SDL_HasSSSE3();
+	if (simd && size == 4 && avx2)
+		return rotate_tile_blocks<8, 4, rotate_8x8_avx2>;
+	if (simd && size == 4 && sse2)
+		return rotate_tile_blocks<4, 4, rotate_4x4_sse2>;
+	if (simd && size == 3 && ssse3)
+		return rotate_tile_blocks<4, 3, rotate_4x4_ssse3>;
+#endif
+
+	switch (size) {
+		case 1:
+			return rotate_tile<1>;
+		case 2:
+			return rotate_tile<2>;
+		case 3:
+			return rotate_tile<3>;
+		default:
+			return rotate_tile<4>;
+	}
+}
+
+void Rotate::rotate_band(const Band& b)
+{
+	// Tiles keep both the rows read & the rows written cache resident
+	for (int ty = 0; ty < b.src->h; ty += _tile) {
+		int ty1 = std::min(ty + _tile, b.src->h);
+		for (int tx = b.x0; tx < b.x1; tx += _tile)
+			b.kernel(b.src, b.dst, b.cw, tx, std::min(tx + _tile, b.x1), ty, ty1);
+	}
+}
+
+void Rotate::run(Work& w)
+{
+	for (size_t i; (i = w.next++) < w.bands.size();) {
+		rotate_band(w.bands[i]);
+		w.done.up();
+	}
+}
+
+void Rotate::rotate_scalar(const SDL_Surface* src, SDL_Surface* dst, bool cw)
+{
+	rotate_band({ src, dst, cw, get_kernel(src->format->BytesPerPixel, false), 0, src->w });
+}
+
+void Rotate::rotate(const SDL_Surface* src, SDL_Surface* dst, bool cw, int threads)
+{
+	Kernel kernel = get_kernel(src->format->BytesPerPixel, true);
+
+	// Only worth spreading out on large pages
+	if (threads <= 0) {
+		threads = (Uint64)src->w * (Uint64)src->h < _parallelpixels
+			? 1
+			: std::min(SDL_GetCPUCount(), _maxthreads);
+	}
+	int tiles = (src->w + _tile - 1) / _tile;
+	threads = std::clamp(threads, 1, std::max(tiles, 1));
+
+	// Bands of whole tiles, each writing its own rows of the output
+	auto work = make_shared<Work>();
+	work->next = 0;
+	int per = (tiles + threads - 1) / threads * _tile;
+	for (int x = 0; x < src->w; x += per)
+		work->bands.push_back({ src, dst, cw, kernel, x, std::min(x + per, src->w) });
+
+	// Idle workers help out while the caller takes bands itself, so it
+	// never waits on jobs queued behind others; late jobs find none left
+	Scheduler& s = Scheduler::get_instance();
+	for (size_t i = 1; i < work->bands.size(); ++i)
+		s.submit(Scheduler::VISIBLE, [work](auto&) { run(*work); });
+	run(*work);
+	for (size_t i = 0; i < work->bands.size(); ++i)
+		work->done.down();
+}
\ No newline at end of file
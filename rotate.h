@@ -0,0 +1,33 @@
+#pragma once
+#include <SDL.h>
+
+/* Quarter-turn rotation of surface pixels into a surface of swapped
+ * dimensions and identical format. Works in cache-sized tiles, with
+ * AVX2 8x8 & SSE2 4x4 transposes for 32-bit pixels and SSSE3 ones for
+ * 24-bit pixels, and splits large images into column bands run on the
+ * scheduler's workers */
+class Rotate {
+	using Kernel = void (*)(const SDL_Surface*, SDL_Surface*, bool, int, int, int, int);
+
+	struct Band {
+		const SDL_Surface* src;
+		SDL_Surface* dst;
+		bool cw;
+		Kernel kernel;
+		int x0;
+		int x1;
+	};
+
+	struct Work;
+
+	static constexpr int _tile = 32;
+	static constexpr int _maxthreads = 8;
+	static constexpr Uint64 _parallelpixels = 4 << 20;
+
+	static Kernel get_kernel(int, bool);
+	static void rotate_band(const Band&);
+	static void run(Work&);
+public:
+	static void rotate(const SDL_Surface*, SDL_Surface*, bool, int = 0);
+	static void rotate_scalar(const SDL_Surface*, SDL_Surface*, bool);
+};
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include "scheduler.h"
+
+using namespace std;
+
+Scheduler::Ticket::Ticket(const Scheduler& s, Priority p, unsigned g)
+	: _sched(s)
+	, _pri(p)
+	, _gen(g)
+{}
+
+bool Scheduler::Ticket::stale() const
+{
+	return !_sched._run || _sched._gen[_pri] != _gen;
+}
+
+Scheduler::Priority Scheduler::Ticket::get_priority() const
+{
+	return _pri;
+}
+
+Scheduler::Scheduler()
+	: _run(true)
+{
+	for (auto& g : _gen)
+		g = 0;
+
+	// One worker per hardware thread
+	int n = std::max(SDL_GetCPUCount(), 1);
+	for (int i = 0; i < n; ++i) {
+		SDL_Thread* t = SDL_CreateThread(work, "th-job", this);
+		if (!t) {
+			cerr << "Failed to create worker thread: " << SDL_GetError() << endl;
+			exit(1);
+		}
+		_threads.push_back(t);
+	}
+}
+
+Scheduler::~Scheduler()
+{
+	stop();
+}
+
+Scheduler& Scheduler::get_instance()
+{
+	static Scheduler instance;
+	return instance;
+}
+
+int SDLCALL Scheduler::work(void* udata)
+{
+	Scheduler* self = static_cast<Scheduler*>(udata);
+
+	Job job;
+	while (self->next(job)) {
+		Ticket t(*self, job.pri, job.gen);
+		if (!t.stale())
+			job.task(t);
+	}
+
+	return 0;
+}
+
+bool Scheduler::next(Job& job)
+{
+	while (true) {
+		_sem.down();
+
+		if (!_run)
+			return false;
+
+		// Pop highest priority job, dropping superseded ones
+		scoped_lock<mutex> lk(_mut);
+		for (auto& q : _queue) {
+			if (q.empty())
+				continue;
+
+			job = move(q.front());
+			q.pop_front();
+			if (job.gen == _gen[job.pri])
+				return true;
+			break;
+		}
+	}
+}
+
+void Scheduler::submit(Priority p, Task&& f)
+{
+	{
+		scoped_lock<mutex> lk(_mut);
+		_queue[p].push_back({ p, _gen[p], move(f) });
+	}
+	_sem.up();
+}
+
+void Scheduler::cancel(Priority p)
+{
+	scoped_lock<mutex> lk(_mut);
+	++_gen[p];
+
+	// Release captured state now, stale jobs are dropped when popped
+	for (auto& job : _queue[p])
+		job.task = nullptr;
+}
+
+void Scheduler::stop()
+{
+	if (!_run.exchange(false))
+		return;
+
+	// Wake & join all workers
+	_sem.up((int)_threads.size());
+	for (SDL_Thread* t : _threads)
+		SDL_WaitThread(t, NULL);
+	_threads.clear();
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#include <functional>
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <SDL.h>
+#include "semaphore.h"
+
+class Scheduler {
+public:
+	enum Priority { VISIBLE, PREFETCH, OVERVIEW, PRIORITIES };
+
+	/* Handed to every running job; becomes stale once the job's
+	 * priority level has been cancelled after it was submitted */
+	class Ticket {
+		const Scheduler& _sched;
+		const Priority _pri;
+		const unsigned _gen;
+		friend class Scheduler;
+
+		Ticket(const Scheduler&, Priority, unsigned);
+	public:
+		bool stale() const;
+		Priority get_priority() const;
+	};
+
+	using Task = std::function<void(const Ticket&)>;
+
+private:
+	struct Job {
+		Priority pri;
+		unsigned gen;
+		Task task;
+	};
+
+	std::deque<Job> _queue[PRIORITIES];
+	std::atomic_uint _gen[PRIORITIES];
+	std::vector<SDL_Thread*> _threads;
+	std::atomic_bool _run;
+	std::mutex _mut;
+	Semaphore _sem;
+
+	Scheduler();
+	static int SDLCALL work(void*);
+	bool next(Job&);
+public:
+	Scheduler(const Scheduler&) = delete;
+	Scheduler& operator=(const Scheduler&) = delete;
+	~Scheduler();
+
+	static Scheduler& get_instance();
+
+	void submit(Priority, Task&&);
+	void cancel(Priority);
+	void stop();
+};
\ No newline at end of file
@@ -6,20 +6,31 @@ Semaphore::Semaphore(int i)
 	: _count(i)
 {}
 
-void Semaphore::up()
+void Semaphore::up(int n)
 {
-	unique_lock<mutex> _lock(_mut);
-	if (++_count <= 0) {
+	scoped_lock<mutex> lk(_mut);
+	_count += n;
+	if (n == 1)
 		_cond.notify_one();
-	}
+	else
+		_cond.notify_all();
 }
 
 void Semaphore::down()
 {
-	unique_lock<mutex> _lock(_mut);
-	if (--_count < 0) {
-		_cond.wait(_lock);
-	}
+	// Re-check count to guard against spurious wake-ups
+	unique_lock<mutex> lk(_mut);
+	_cond.wait(lk, [this]() { return _count > 0; });
+	--_count;
+}
+
+bool Semaphore::try_down()
+{
+	scoped_lock<mutex> lk(_mut);
+	if (_count <= 0)
+		return false;
+	--_count;
+	return true;
 }
 
 Semaphore::operator int()
@@ -3,14 +3,14 @@
 #include <mutex>
 
 class Semaphore {
-protected:
 	std::mutex _mut;
 	std::condition_variable _cond;
 	int _count;
 public:
 	Semaphore(int i = 0);
 
-	virtual void up();
-	virtual void down();
+	void up(int n = 1);
+	void down();
+	bool try_down();
 	operator int();
 };
\ No newline at end of file
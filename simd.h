@@ -0,0 +1,24 @@
+#pragma once
+#include <SDL.h>
+
+/* Intrinsics for the pixel kernels, each vector routine is compiled for
+ * its instruction set alone & only called once SDL reports support */
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#endif
+#endif
+
+/* Whole pixel of N bytes, moved as one unit */
+template <int N>
+struct Pixel {
+	Uint8 v[N];
+};
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <utility>
+#include "surfcache.h"
+
+using namespace std;
+
+SurfaceCache::SurfaceCache()
+	: _budget(256 << 20)
+	, _stats{ 0, 0, 0, 0, 0 }
+{}
+
+SurfaceCache& SurfaceCache::get_instance()
+{
+	static SurfaceCache instance;
+	return instance;
+}
+
+size_t SurfaceCache::get_bytes(const SDL_Surface* s)
+{
+	return (size_t)s->pitch * (size_t)s->h;
+}
+
+void SurfaceCache::evict()
+{
+	// Drop least recently used entries until within budget
+	while (_stats.bytes > _budget && !_lru.empty()) {
+		Entry& e = _lru.back();
+		_stats.bytes -= get_bytes(e.second.get());
+		_map.erase(e.first);
+		_lru.pop_back();
+		++_stats.evictions;
+	}
+	_stats.entries = _lru.size();
+}
+
+SurfaceCache::Surface SurfaceCache::load(const string& key, const Decoder& decode)
+{
+	{
+		unique_lock<mutex> lk(_mut);
+
+		// Wait for another thread decoding the same key
+		_cond.wait(lk, [&]() {
+			return std::find(_pending.begin(), _pending.end(), key) == _pending.end();
+		});
+
+		auto it = _map.find(key);
+		if (it != _map.end()) {
+			++_stats.hits;
+			_lru.splice(_lru.begin(), _lru, it->second);
+			return it->second->second;
+		}
+
+		++_stats.misses;
+		_pending.push_back(key);
+	}
+
+	// Decode without holding the lock
+	SDL_Surface* s = decode();
+	Surface surf(s, [](SDL_Surface* p) { SDL_FreeSurface(p); });
+
+	{
+		scoped_lock<mutex> lk(_mut);
+		_pending.remove(key);
+		if (s) {
+			_lru.emplace_front(key, surf);
+			_map[key] = _lru.begin();
+			_stats.bytes += get_bytes(s);
+			evict();
+		}
+	}
+	_cond.notify_all();
+
+	return surf;
+}
+
+SurfaceCache::Surface SurfaceCache::find(const string& key)
+{
+	scoped_lock<mutex> lk(_mut);
+	auto it = _map.find(key);
+	if (it == _map.end())
+		return nullptr;
+
+	_lru.splice(_lru.begin(), _lru, it->second);
+	return it->second->second;
+}
+
+void SurfaceCache::set_budget(size_t b)
+{
+	scoped_lock<mutex> lk(_mut);
+	_budget = b;
+	evict();
+}
+
+size_t SurfaceCache::get_budget() const
+{
+	scoped_lock<mutex> lk(_mut);
+	return _budget;
+}
+
+SurfaceCache::Stats SurfaceCache::get_stats() const
+{
+	scoped_lock<mutex> lk(_mut);
+	return _stats;
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#include <unordered_map>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <string>
+#include <mutex>
+#include <list>
+#include <SDL.h>
+
+class SurfaceCache {
+public:
+	using Surface = std::shared_ptr<SDL_Surface>;
+	using Decoder = std::function<SDL_Surface*()>;
+
+	struct Stats {
+		size_t hits;
+		size_t misses;
+		size_t evictions;
+		size_t bytes;
+		size_t entries;
+	};
+
+private:
+	using Entry = std::pair<std::string, Surface>;
+
+	std::list<Entry> _lru;
+	std::unordered_map<std::string, std::list<Entry>::iterator> _map;
+	std::list<std::string> _pending;
+	mutable std::mutex _mut;
+	std::condition_variable _cond;
+	size_t _budget;
+	Stats _stats;
+
+	SurfaceCache();
+	void evict();
+public:
+	SurfaceCache(const SurfaceCache&) = delete;
+	SurfaceCache& operator=(const SurfaceCache&) = delete;
+
+	static SurfaceCache& get_instance();
+	static size_t get_bytes(const SDL_Surface*);
+
+	Surface load(const std::string&, const Decoder&);
+	Surface find(const std::string&);
+
+	void set_budget(size_t);
+	size_t get_budget() const;
+	Stats get_stats() const;
+};
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include <cstring>
+#include "util.h"
+#include "tar.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+/* Numeric header fields are NUL/space terminated octal, or base-256
+ * when the high bit of the first byte is set (GNU, for sizes >= 8 GiB) */
+static bool rdnum(const Uint8* p, size_t n, Uint64* out)
+{
+	Uint64 v = 0;
+	if (p[0] & 0x80) {
+		v = p[0] & 0x7F;
+		for (size_t i = 1; i < n; ++i)
+			v = (v << 8) | p[i];
+		*out = v;
+		return true;
+	}
+
+	size_t i = 0;
+	while (i < n && p[i] == ' ')
+		++i;
+	for (; i < n && p[i] >= '0' && p[i] <= '7'; ++i)
+		v = (v << 3) | (Uint64)(p[i] - '0');
+	if (i < n && p[i] != ' ' && p[i] != '\0')
+		return false;
+
+	*out = v;
+	return true;
+}
+
+static string rdstr(const Uint8* p, size_t n)
+{
+	return string((const char*)p, strnlen((const char*)p, n));
+}
+
+/* Header checksum, the checksum field itself counts as spaces */
+static bool checksum(const Uint8* h)
+{
+	Uint64 sum;
+	if (!rdnum(h + 148, 8, &sum))
+		return false;
+
+	Uint64 u = 8 * ' ';
+	for (size_t i = 0; i < 512; ++i) {
+		if (i < 148 || i >= 156)
+			u += h[i];
+	}
+	return u == sum;
+}
+
+/* Pull the path record out of a pax extended header */
+static string pax_path(const Uint8* p, Uint64 n)
+{
+	string path;
+	Uint64 i = 0;
+	while (i < n) {
+		// Each record is "<len> <key>=<value>\n", len covering the whole record
+		Uint64 len = 0, j = i;
+		while (j < n && p[j] >= '0' && p[j] <= '9')
+			len = len * 10 + (p[j++] - '0');
+		if (j >= n || p[j] != ' ' || len == 0 || len > n - i)
+			break;
+
+		string rec((const char*)p + j + 1, (size_t)(len - (j + 1 - i)));
+		if (!rec.compare(0, 5, "path=") && !rec.empty() && rec.back() == '\n')
+			path = rec.substr(5, rec.size() - 6);
+		i += len;
+	}
+	return path;
+}
+
+Tar::Tar(const fs::path& p)
+	: _path(p)
+	, _file(p, false)
+{
+	error_code ec;
+	auto t = fs::last_write_time(p, ec);
+	_key = p.string() + '|' + to_string(_file.size()) + '|' + to_string(ec ? 0 : t.time_since_epoch().count()) + '|';
+}
+
+shared_ptr<Tar> Tar::open(const fs::path& p)
+{
+	shared_ptr<Tar> t(new Tar(p));
+	if (!t->_file || !t->parse())
+		return nullptr;
+	return t;
+}
+
+bool Tar::parse()
+{
+	const Uint8* d = _file.data();
+	Uint64 n = _file.size();
+
+	// Names from GNU long-name & pax headers apply to the next member
+	string longname;
+	Uint64 p = 0;
+	while (p + 512 <= n) {
+		const Uint8* h = d + p;
+
+		// End of archive is marked by zero blocks
+		if (h[0] == '\0' && h[148] == '\0')
+			break;
+		if (!checksum(h))
+			return false;
+
+		Uint64 size;
+		if (!rdnum(h + 124, 12, &size))
+			return false;
+
+		Uint64 data = p + 512;
+		if (size > n - data)
+			return false;
+		p = data + ((size + 511) & ~(Uint64)511);
+
+		char type = (char)h[156];
+		if (type == 'L') {
+			longname = rdstr(d + data, (size_t)size);
+			continue;
+		}
+		if (type == 'x') {
+			longname = pax_path(d + data, size);
+			continue;
+		}
+
+		string name = longname;
+		longname.clear();
+		if (name.empty()) {
+			name = rdstr(h, 100);
+
+			// POSIX ustar splits long paths into prefix & name
+			if (!memcmp(h + 257, "ustar", 5) && h[345] != '\0')
+				name = rdstr(h + 345, 155) + '/' + name;
+		}
+
+		// Keep regular files with an image extension only
+		if ((type != '0' && type != '\0' && type != '7') || !Util::has_image_ext(name))
+			continue;
+
+		_entries.push_back({ data, size, (Uint32)_names.size(), (Uint32)name.size() });
+		_names += name;
+	}
+
+	return true;
+}
+
+size_t Tar::count() const
+{
+	return _entries.size();
+}
+
+string Tar::get_name(size_t i) const
+{
+	const Entry& e = _entries[i];
+	return _names.substr(e.name, e.namelen);
+}
+
+string Tar::get_key(size_t i) const
+{
+	return _key + get_name(i);
+}
+
+Buffer Tar::read(size_t i) const
+{
+	// Members are never compressed, hand out a slice of the mapping
+	const Entry& e = _entries[i];
+	return Buffer(shared_from_this(), _file.data() + e.offset, (size_t)e.size);
+}
+
+vector<shared_ptr<Page>> Tar::get_pages() const
+{
+	vector<shared_ptr<Page>> v;
+	for (size_t i = 0; i < _entries.size(); ++i)
+		v.push_back(make_shared<TarPage>(shared_from_this(), i));
+	return v;
+}
+
+TarPage::TarPage(shared_ptr<const Tar> t, size_t i)
+	: _tar(move(t))
+	, _index(i)
+{}
+
+string TarPage::get_name() const
+{
+	return _tar->get_name(_index);
+}
+
+string TarPage::get_key() const
+{
+	return _tar->get_key(_index);
+}
+
+Buffer TarPage::read() const
+{
+	return _tar->read(_index);
+}
\ No newline at end of file
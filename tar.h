@@ -0,0 +1,48 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include "mapped.h"
+#include "page.h"
+
+/* Reader for uncompressed tar (.cbt) archives, the headers are walked
+ * once into an offset index and members are sliced from the mapping */
+class Tar : public std::enable_shared_from_this<Tar> {
+	struct Entry {
+		Uint64 offset;
+		Uint64 size;
+		Uint32 name;
+		Uint32 namelen;
+	};
+
+	const std::filesystem::path _path;
+	MappedFile _file;
+	std::string _names;
+	std::vector<Entry> _entries;
+	std::string _key;
+
+	Tar(const std::filesystem::path&);
+	bool parse();
+public:
+	static std::shared_ptr<Tar> open(const std::filesystem::path&);
+
+	size_t count() const;
+	std::string get_name(size_t) const;
+	std::string get_key(size_t) const;
+	Buffer read(size_t) const;
+
+	std::vector<std::shared_ptr<Page>> get_pages() const;
+};
+
+class TarPage final : public Page {
+	const std::shared_ptr<const Tar> _tar;
+	const size_t _index;
+public:
+	TarPage(std::shared_ptr<const Tar>, size_t);
+
+	std::string get_name() const override;
+	std::string get_key() const override;
+	Buffer read() const override;
+};
\ No newline at end of file
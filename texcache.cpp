@@ -0,0 +1,107 @@
+#include <algorithm>
+#include "texcache.h"
+#include "render.h"
+
+using namespace std;
+
+TextureCache::TextureCache()
+	: _budget(256 << 20)
+	, _bytes(0)
+{
+	// Budget a few maximum sized textures when the renderer reports a limit
+	int w, h;
+	RenderWindow::get_instance().get_max_texture_size(&w, &h);
+	if (w && h)
+		_budget = std::min(_budget, (size_t)w * (size_t)h * 4 * 2);
+}
+
+TextureCache::~TextureCache()
+{
+	clear();
+}
+
+TextureCache& TextureCache::get_instance()
+{
+	static TextureCache instance;
+	return instance;
+}
+
+Tiles TextureCache::take(const string& key)
+{
+	scoped_lock<mutex> lk(_mut);
+	auto it = _map.find(key);
+	if (it == _map.end())
+		return Tiles();
+
+	Tiles t = move(it->second->second);
+	_bytes -= t.get_bytes();
+	_lru.erase(it->second);
+	_map.erase(it);
+	return t;
+}
+
+void TextureCache::put(const string& key, Tiles&& t)
+{
+	scoped_lock<mutex> lk(_mut);
+
+	// Replace existing entry, may be called off the render thread
+	auto it = _map.find(key);
+	if (it != _map.end()) {
+		_bytes -= it->second->second.get_bytes();
+		_orphans.push_back(move(it->second->second));
+		_lru.erase(it->second);
+	}
+
+	_bytes += t.get_bytes();
+	_lru.emplace_front(key, move(t));
+	_map[key] = _lru.begin();
+}
+
+void TextureCache::release(Tiles&& t)
+{
+	// Destroyed on the next trim, may be called off the render thread
+	scoped_lock<mutex> lk(_mut);
+	_orphans.push_back(move(t));
+}
+
+bool TextureCache::contains(const string& key) const
+{
+	scoped_lock<mutex> lk(_mut);
+	return _map.count(key);
+}
+
+// Must be called from the render thread
+void TextureCache::trim()
+{
+	// Destroy replaced & least recently used textures until within budget
+	scoped_lock<mutex> lk(_mut);
+	_orphans.clear();
+
+	while (_bytes > _budget && !_lru.empty()) {
+		Entry& e = _lru.back();
+		_bytes -= e.second.get_bytes();
+		_map.erase(e.first);
+		_lru.pop_back();
+	}
+}
+
+void TextureCache::clear()
+{
+	scoped_lock<mutex> lk(_mut);
+	_orphans.clear();
+	_lru.clear();
+	_map.clear();
+	_bytes = 0;
+}
+
+void TextureCache::set_budget(size_t b)
+{
+	scoped_lock<mutex> lk(_mut);
+	_budget = b;
+}
+
+size_t TextureCache::get_budget() const
+{
+	scoped_lock<mutex> lk(_mut);
+	return _budget;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <list>
+#include <SDL.h>
+#include "tiles.h"
+
+class TextureCache {
+	using Entry = std::pair<std::string, Tiles>;
+
+	std::list<Entry> _lru;
+	std::unordered_map<std::string, std::list<Entry>::iterator> _map;
+	std::vector<Tiles> _orphans;
+	mutable std::mutex _mut;
+	size_t _budget;
+	size_t _bytes;
+
+	TextureCache();
+public:
+	TextureCache(const TextureCache&) = delete;
+	TextureCache& operator=(const TextureCache&) = delete;
+	~TextureCache();
+
+	static TextureCache& get_instance();
+
+	Tiles take(const std::string&);
+	void put(const std::string&, Tiles&&);
+	void release(Tiles&&);
+	bool contains(const std::string&) const;
+	void trim();
+	void clear();
+
+	void set_budget(size_t);
+	size_t get_budget() const;
+};
\ No newline at end of file
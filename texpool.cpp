@@ -0,0 +1,76 @@
+#include "texpool.h"
+#include "render.h"
+
+using namespace std;
+
+TexturePool::TexturePool()
+	: _budget(64 << 20)
+	, _bytes(0)
+{}
+
+TexturePool::~TexturePool()
+{
+	clear();
+}
+
+TexturePool& TexturePool::get_instance()
+{
+	static TexturePool instance;
+	return instance;
+}
+
+size_t TexturePool::get_bytes(SDL_Texture* t)
+{
+	Uint32 fmt;
+	int w, h;
+	SDL_QueryTexture(t, &fmt, nullptr, &w, &h);
+	return (size_t)w * (size_t)h * SDL_BYTESPERPIXEL(fmt);
+}
+
+SDL_Texture* TexturePool::acquire(Uint32 fmt, int w, int h)
+{
+	// Re-use a free texture of identical format & dimensions
+	for (auto it = _free.begin(); it != _free.end(); ++it) {
+		Uint32 f;
+		int tw, th;
+		SDL_QueryTexture(*it, &f, nullptr, &tw, &th);
+		if (f == fmt && tw == w && th == h) {
+			SDL_Texture* t = *it;
+			_bytes -= get_bytes(t);
+			_free.erase(it);
+			return t;
+		}
+	}
+
+	return SDL_CreateTexture(
+		RenderWindow::get_instance().get_renderer(),
+		fmt,
+		SDL_TEXTUREACCESS_STREAMING,
+		w,
+		h
+	);
+}
+
+void TexturePool::recycle(SDL_Texture* t)
+{
+	if (!t)
+		return;
+
+	_free.push_front(t);
+	_bytes += get_bytes(t);
+
+	// Destroy least recently freed textures over budget
+	while (_bytes > _budget && !_free.empty()) {
+		_bytes -= get_bytes(_free.back());
+		SDL_DestroyTexture(_free.back());
+		_free.pop_back();
+	}
+}
+
+void TexturePool::clear()
+{
+	for (SDL_Texture* t : _free)
+		SDL_DestroyTexture(t);
+	_free.clear();
+	_bytes = 0;
+}
\ No newline at end of file
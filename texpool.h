@@ -0,0 +1,24 @@
+#pragma once
+#include <list>
+#include <SDL.h>
+
+/* Free streaming textures kept around for re-use, only to be
+ * used from the render thread */
+class TexturePool {
+	std::list<SDL_Texture*> _free;
+	size_t _budget;
+	size_t _bytes;
+
+	TexturePool();
+public:
+	TexturePool(const TexturePool&) = delete;
+	TexturePool& operator=(const TexturePool&) = delete;
+	~TexturePool();
+
+	static TexturePool& get_instance();
+	static size_t get_bytes(SDL_Texture*);
+
+	SDL_Texture* acquire(Uint32, int, int);
+	void recycle(SDL_Texture*);
+	void clear();
+};
\ No newline at end of file
@@ -1,9 +1,8 @@
-#include <iostream>
 #include <utility>
 #include "text.h"
-#include "render.h"
+#include "glyphcache.h"
+#include "atlas.h"
 #include "control.h"
-#include "util.h"
 
 using namespace std;
 
@@ -26,55 +25,79 @@ Text::Text(Text&& other)
 	: Widget(forward<Widget>(other))
 	, _color(exchange(other._color, {0}))
 	, _string(move(other._string))
+	, _quads(move(other._quads))
 {}
 
+/* Decode one UTF-8 sequence, malformed input yields U+FFFD */
+static Uint32 next_codepoint(const string& s, size_t& i)
+{
+	Uint8 c = (Uint8)s[i++];
+	int n = (c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0);
+	if (c >= 0x80 && n == 0)
+		return 0xFFFD;
+
+	Uint32 cp = (n ? c & (0x3F >> n) : c);
+	for (; n > 0; --n) {
+		if (i >= s.size() || ((Uint8)s[i] & 0xC0) != 0x80)
+			return 0xFFFD;
+		cp = (cp << 6) | ((Uint8)s[i++] & 0x3F);
+	}
+	return cp;
+}
+
 void Text::set_string(const string& s)
 {
-	aquire(_mut);
+	if (s == _string && !_quads.empty())
+		return;
 	_string = s;
+	++_revision;
+
+	// Lay out cached glyphs, nothing is rasterised once they are known
+	TTF_Font* font = Text::_font.get();
+	GlyphCache& gc = GlyphCache::get_instance();
+	_quads.clear();
 
-	// Free old surface
-	SDL_FreeSurface(_surface);
+	int x = 0;
+	Uint32 prev = 0;
+	for (size_t i = 0; i < _string.size();) {
+		Uint32 c = next_codepoint(_string, i);
+		if (prev)
+			x += GlyphCache::get_kerning(font, prev, c);
 
-	// Load text into surface
-	_surface = TTF_RenderUTF8_Blended(
-		Text::_font.get(),
-		_string.c_str(), 
-		_color
-	);
-	if (!_surface) {
-		cerr << "Failed to create surface: " << TTF_GetError() << endl;
-		exit(1);
+		GlyphCache::Glyph g = gc.get(font, c);
+		if (g.src.w > 0)
+			_quads.emplace_back(g.src, x + g.x);
+		x += g.advance;
+		prev = c;
 	}
 
 	// Set widget size
-	_w = _surface->w;
-	_h = _surface->h;
-	_uflag = true;
+	_w = x;
+	_h = TTF_FontHeight(font);
 }
 
 string Text::get_string() const
 {
-	aquire(_mut);
 	return _string;
 }
 
 void Text::set_color(Uint8 r, Uint8 g, Uint8 b, Uint8 a)
 {
-	aquire(_mut);
 	_color = { r, g, b, a };
-	set_string(_string);
+	++_revision;
 }
 
 SDL_Color Text::get_color() const
 {
-	aquire(_mut);
 	return _color;
 }
 
 void Text::draw() const
 {
-	aquire(_mut);
-	SDL_Rect dst = { _x, _y, _w, _h };
-	RenderWindow::get_instance().render(_texture, &dst);
+	// Glyphs are white, tinted by the vertex color
+	SpriteAtlas& atlas = SpriteAtlas::get_instance();
+	for (auto& [src, x] : _quads) {
+		SDL_Rect dst = { _x + x, _y, src.w, src.h };
+		atlas.queue(src, dst, _color);
+	}
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 #include <functional>
 #include <memory>
+#include <utility>
 #include <string>
+#include <vector>
 #include <SDL.h>
 #include <SDL_ttf.h>
 #include "widget.h"
@@ -12,6 +14,7 @@ class Text final : public Widget {
 
 	SDL_Color _color;
 	std::string _string;
+	std::vector<std::pair<SDL_Rect, int>> _quads;
 public:
 	Text(const std::string&);
 	Text(Text&&);
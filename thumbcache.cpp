@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include "thumbcache.h"
+#include "mapped.h"
+#include "convert.h"
+#include "image.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+/* File layout, host byte order:
+ *   magic, version, key length, key,
+ *   width, height, pixel format, DCT-scalable flag,
+ *   thumbnail width, height & ARGB8888 pixels */
+struct Header {
+	Uint32 magic;
+	Uint32 version;
+	Uint32 keylen;
+};
+
+struct Body {
+	Sint32 w;
+	Sint32 h;
+	Uint32 format;
+	Uint32 scalable;
+	Sint32 tw;
+	Sint32 th;
+};
+
+ThumbCache::ThumbCache()
+	: _dir(get_default_dir())
+{}
+
+ThumbCache& ThumbCache::get_instance()
+{
+	static ThumbCache instance;
+	return instance;
+}
+
+fs::path ThumbCache::get_default_dir()
+{
+	// $XDG_CACHE_HOME, falling back to ~/.cache as the spec says
+	fs::path base;
+#ifdef _WIN32
+	if (const char* s = getenv("LOCALAPPDATA"))
+		base = s;
+#else
+	const char* s = getenv("XDG_CACHE_HOME");
+	if (s && fs::path(s).is_absolute())
+		base = s;
+	else if ((s = getenv("HOME")))
+		base = fs::path(s) / ".cache";
+#endif
+	if (base.empty())
+		return base;
+	return base / "comix" / "pages";
+}
+
+int ThumbCache::get_size()
+{
+	return _size;
+}
+
+fs::path ThumbCache::get_file(const string& key) const
+{
+	// FNV-1a of the key, the key itself is stored to rule out collisions
+	Uint64 h = 0xcbf29ce484222325ull;
+	for (unsigned char c : key)
+		h = (h ^ c) * 0x100000001b3ull;
+
+	char name[24];
+	SDL_snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)h);
+	return _dir / name;
+}
+
+bool ThumbCache::read(const string& key, Meta* meta, SDL_Surface** thumb) const
+{
+	if (_dir.empty())
+		return false;
+
+	MappedFile f(get_file(key));
+	if (!f)
+		return false;
+
+	// Validate header & key before trusting any sizes
+	const Uint8* d = f.data();
+	size_t n = f.size();
+	Header hd;
+	if (n < sizeof(hd))
+		return false;
+	memcpy(&hd, d, sizeof(hd));
+	if (hd.magic != _magic || hd.version != _version || hd.keylen != key.size())
+		return false;
+
+	size_t off = sizeof(hd) + hd.keylen;
+	Body b;
+	if (n < off + sizeof(b) || memcmp(d + sizeof(hd), key.data(), key.size()))
+		return false;
+	memcpy(&b, d + off, sizeof(b));
+	off += sizeof(b);
+
+	if (b.w <= 0 || b.h <= 0 || b.tw <= 0 || b.th <= 0 || b.tw > _size || b.th > _size)
+		return false;
+	size_t pitch = (size_t)b.tw * 4;
+	if (n < off + pitch * (size_t)b.th)
+		return false;
+
+	*meta = { b.w, b.h, b.format, b.scalable != 0 };
+	if (!thumb)
+		return true;
+
+	*thumb = SDL_CreateRGBSurfaceWithFormat(0, b.tw, b.th, 32, SDL_PIXELFORMAT_ARGB8888);
+	if (!*thumb)
+		return false;
+	for (int y = 0; y < b.th; ++y)
+		memcpy((Uint8*)(*thumb)->pixels + y * (*thumb)->pitch, d + off + y * pitch, pitch);
+	return true;
+}
+
+void ThumbCache::write(const string& key, const Meta& meta, const SDL_Surface* thumb) const
+{
+	if (_dir.empty() || !thumb)
+		return;
+
+	error_code ec;
+	fs::create_directories(_dir, ec);
+	if (ec)
+		return;
+
+	// Write aside & rename, so readers never see a partial file
+	fs::path p = get_file(key);
+	fs::path tmp = p;
+	tmp += '.' + to_string(SDL_ThreadID());
+	{
+		ofstream out(tmp, ios::binary | ios::trunc);
+		if (!out)
+			return;
+
+		Header hd = { _magic, _version, (Uint32)key.size() };
+		Body b = { meta.w, meta.h, meta.format, meta.scalable, thumb->w, thumb->h };
+		out.write((const char*)&hd, sizeof(hd));
+		out.write(key.data(), key.size());
+		out.write((const char*)&b, sizeof(b));
+		for (int y = 0; y < thumb->h; ++y)
+			out.write((const char*)thumb->pixels + y * thumb->pitch, thumb->w * 4);
+		if (!out) {
+			out.close();
+			fs::remove(tmp, ec);
+			return;
+		}
+	}
+
+	fs::rename(tmp, p, ec);
+	if (ec)
+		fs::remove(tmp, ec);
+}
+
+SDL_Surface* ThumbCache::shrink(const SDL_Surface* src)
+{
+	SDL_Surface* conv = Convert::to_bytes((SDL_Surface*)src);
+	if (!conv)
+		return nullptr;
+	if (conv == src)
+		conv = nullptr;
+	else
+		src = conv;
+
+	// Fit into the thumbnail box, never enlarging
+	float f = std::min({ (float)_size / (float)src->w, (float)_size / (float)src->h, 1.f });
+	int w = std::max((int)((float)src->w * f + .5f), 1);
+	int h = std::max((int)((float)src->h * f + .5f), 1);
+	SDL_Surface* out = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, src->format->format);
+	if (!out) {
+		SDL_FreeSurface(conv);
+		return nullptr;
+	}
+
+	// Average every source pixel covered by each thumbnail pixel
+	const Uint8* pixels = (const Uint8*)src->pixels;
+	for (int y = 0; y < h; ++y) {
+		int y0 = y * src->h / h;
+		int y1 = std::max((y + 1) * src->h / h, y0 + 1);
+		Uint32* dst = (Uint32*)((Uint8*)out->pixels + y * out->pitch);
+		for (int x = 0; x < w; ++x) {
+			int x0 = x * src->w / w;
+			int x1 = std::max((x + 1) * src->w / w, x0 + 1);
+
+			Uint32 sum[4] = { 0, 0, 0, 0 };
+			for (int sy = y0; sy < y1; ++sy) {
+				const Uint8* p = pixels + sy * src->pitch + x0 * 4;
+				for (int sx = x0; sx < x1; ++sx, p += 4) {
+					sum[0] += p[0];
+					sum[1] += p[1];
+					sum[2] += p[2];
+					sum[3] += p[3];
+				}
+			}
+
+			Uint32 n = (Uint32)((y1 - y0) * (x1 - x0));
+			Uint8* q = (Uint8*)(dst + x);
+			for (int c = 0; c < 4; ++c)
+				q[c] = (Uint8)((sum[c] + n / 2) / n);
+		}
+	}
+	SDL_FreeSurface(conv);
+
+	// Thumbnails are stored in one fixed format
+	if (out->format->format != SDL_PIXELFORMAT_ARGB8888) {
+		SDL_Surface* argb = SDL_ConvertSurfaceFormat(out, SDL_PIXELFORMAT_ARGB8888, 0);
+		SDL_FreeSurface(out);
+		out = argb;
+	}
+	return out;
+}
+
+bool ThumbCache::find(const Page& p, Meta* meta)
+{
+	string key = p.get_key();
+	{
+		lock_guard<mutex> lk(_mut);
+		auto it = _meta.find(key);
+		if (it != _meta.end()) {
+			*meta = it->second;
+			return true;
+		}
+	}
+
+	// Header only, thumbnails are read on demand
+	if (!read(key, meta, nullptr))
+		return false;
+
+	lock_guard<mutex> lk(_mut);
+	_meta[key] = *meta;
+	return true;
+}
+
+SDL_Surface* ThumbCache::load(const Page& p)
+{
+	string key = p.get_key();
+	Meta meta;
+	SDL_Surface* thumb = nullptr;
+	if (read(key, &meta, &thumb)) {
+		lock_guard<mutex> lk(_mut);
+		_meta[key] = meta;
+		return thumb;
+	}
+
+	// Decode at the smallest scale the decoder offers & remember the result
+	SDL_Surface* s = Image::read(p, p.is_jpeg() ? 8 : 1, &meta);
+	if (!s)
+		return nullptr;
+
+	thumb = shrink(s);
+	put(p, meta, thumb);
+	SDL_FreeSurface(s);
+	return thumb;
+}
+
+void ThumbCache::put(const Page& p, const Meta& meta, const SDL_Surface* s)
+{
+	string key = p.get_key();
+	{
+		lock_guard<mutex> lk(_mut);
+		if (!_meta.emplace(key, meta).second)
+			return;
+	}
+
+	// Callers may hand in a full page, shrink it first
+	if (s && (s->w > _size || s->h > _size || s->format->format != SDL_PIXELFORMAT_ARGB8888)) {
+		SDL_Surface* thumb = shrink(s);
+		write(key, meta, thumb);
+		SDL_FreeSurface(thumb);
+	} else {
+		write(key, meta, s);
+	}
+}
+
+void ThumbCache::set_dir(const fs::path& p)
+{
+	lock_guard<mutex> lk(_mut);
+	_dir = p;
+}
+
+const fs::path& ThumbCache::get_dir() const
+{
+	return _dir;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include <unordered_map>
+#include <filesystem>
+#include <string>
+#include <mutex>
+#include <SDL.h>
+#include "page.h"
+
+/* Page dimensions & small previews kept on disk across launches, one
+ * compact binary file per page under the XDG cache directory, keyed
+ * by the page's path, size & modification time */
+class ThumbCache {
+public:
+	struct Meta {
+		int w;
+		int h;
+		Uint32 format;
+		bool scalable;
+	};
+
+private:
+	std::unordered_map<std::string, Meta> _meta;
+	mutable std::mutex _mut;
+	std::filesystem::path _dir;
+
+	static const Uint32 _magic = 0x54584d43;
+	static const Uint32 _version = 1;
+	static const int _size = 192;
+
+	ThumbCache();
+	std::filesystem::path get_file(const std::string&) const;
+	bool read(const std::string&, Meta*, SDL_Surface**) const;
+	void write(const std::string&, const Meta&, const SDL_Surface*) const;
+	static SDL_Surface* shrink(const SDL_Surface*);
+public:
+	ThumbCache(const ThumbCache&) = delete;
+	ThumbCache& operator=(const ThumbCache&) = delete;
+
+	static ThumbCache& get_instance();
+	static std::filesystem::path get_default_dir();
+	static int get_size();
+
+	bool find(const Page&, Meta*);
+	SDL_Surface* load(const Page&);
+	void put(const Page&, const Meta&, const SDL_Surface*);
+
+	void set_dir(const std::filesystem::path&);
+	const std::filesystem::path& get_dir() const;
+};
\ No newline at end of file
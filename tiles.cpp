@@ -0,0 +1,249 @@
+#include <iostream>
+#include <algorithm>
+#include <utility>
+#include <cstdlib>
+#include "texpool.h"
+#include "tiles.h"
+#include "render.h"
+
+using namespace std;
+
+Tiles::Tiles()
+	: _source(nullptr)
+	, _conv(nullptr)
+	, _stripe(0)
+	, _w(0)
+	, _h(0)
+{}
+
+Tiles::Tiles(Tiles&& other)
+	: _tiles(move(other._tiles))
+	, _source(exchange(other._source, nullptr))
+	, _conv(exchange(other._conv, nullptr))
+	, _stripe(exchange(other._stripe, 0))
+	, _w(exchange(other._w, 0))
+	, _h(exchange(other._h, 0))
+{
+	other._tiles.clear();
+}
+
+Tiles& Tiles::operator=(Tiles&& other)
+{
+	if (this != &other) {
+		clear();
+		swap(_tiles, other._tiles);
+		_source = exchange(other._source, nullptr);
+		_conv = exchange(other._conv, nullptr);
+		_stripe = exchange(other._stripe, 0);
+		_w = exchange(other._w, 0);
+		_h = exchange(other._h, 0);
+	}
+	return *this;
+}
+
+Tiles::~Tiles()
+{
+	clear();
+}
+
+SDL_Rect Tiles::map(const SDL_Rect& src, const SDL_Rect& dst, const Orientation& o) const
+{
+	// Orient surface rect, then map it onto the destination, shared
+	// edges round alike
+	int w = _w;
+	int h = _h;
+	SDL_Rect s = o.map(src, w, h);
+	o.get_size(&w, &h);
+
+	int x0 = dst.x + (int)((Sint64)s.x * dst.w / w);
+	int y0 = dst.y + (int)((Sint64)s.y * dst.h / h);
+	int x1 = dst.x + (int)((Sint64)(s.x + s.w) * dst.w / w);
+	int y1 = dst.y + (int)((Sint64)(s.y + s.h) * dst.h / h);
+	return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+void Tiles::begin(SDL_Surface* s)
+{
+	clear();
+
+	// Textures can't be palettized, convert those up front
+	if (SDL_ISPIXELFORMAT_INDEXED(s->format->format)) {
+		_conv = SDL_ConvertSurfaceFormat(s, SDL_PIXELFORMAT_ARGB8888, 0);
+		if (!_conv) {
+			cerr << "Failed to convert surface: " << SDL_GetError() << endl;
+			exit(1);
+		}
+		s = _conv;
+	}
+
+	_source = s;
+	_w = s->w;
+	_h = s->h;
+	_stripe = std::max(1, (int)(_stripebytes / (size_t)s->pitch));
+
+	// Use a single texture when the renderer allows it
+	int maxw, maxh;
+	RenderWindow::get_instance().get_max_texture_size(&maxw, &maxh);
+
+	int tw = (!maxw || _w <= maxw ? _w : std::min(maxw, _tilesize));
+	int th = (!maxh || _h <= maxh ? _h : std::min(maxh, _tilesize));
+
+	// Create textures only, pixels follow stripe by stripe
+	Uint32 fmt = s->format->format;
+	for (int y = 0; y < _h; y += th) {
+		for (int x = 0; x < _w; x += tw) {
+			SDL_Rect src = { x, y, std::min(tw, _w - x), std::min(th, _h - y) };
+			SDL_Texture* t = TexturePool::get_instance().acquire(fmt, src.w, src.h);
+			if (!t) {
+				cerr << "Failed to create texture: " << SDL_GetError() << endl;
+				exit(1);
+			}
+			SDL_SetTextureBlendMode(t, SDL_ISPIXELFORMAT_ALPHA(fmt) ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE);
+
+			size_t n = (size_t)((src.h + _stripe - 1) / _stripe);
+			_tiles.push_back({ src, t, vector<bool>(n, false), 0 });
+		}
+	}
+}
+
+void Tiles::upload_stripe(Tile& t, size_t i)
+{
+	int y = (int)i * _stripe;
+	SDL_Rect r = { 0, y, t.src.w, std::min(_stripe, t.src.h - y) };
+	const Uint8* pixels = (const Uint8*)_source->pixels
+		+ (t.src.y + y) * _source->pitch
+		+ t.src.x * _source->format->BytesPerPixel;
+
+	SDL_UpdateTexture(t.texture, &r, pixels, _source->pitch);
+	t.stripes[i] = true;
+	++t.uploaded;
+}
+
+bool Tiles::finish()
+{
+	if (!ready())
+		return false;
+
+	// Source no longer needed once everything is uploaded
+	SDL_FreeSurface(_conv);
+	_conv = nullptr;
+	_source = nullptr;
+	return true;
+}
+
+bool Tiles::step(const SDL_Rect& dst, const Orientation& o, size_t budget)
+{
+	if (!_source)
+		return true;
+
+	SDL_Rect view = { 0, 0, 0, 0 };
+	RenderWindow::get_instance().get_size(&view.w, &view.h);
+
+	// Visible stripes first, then the rest, until the budget is spent
+	size_t spent = 0;
+	for (int pass = 0; pass < 2; ++pass) {
+		for (Tile& t : _tiles) {
+			for (size_t i = 0; i < t.stripes.size(); ++i) {
+				if (t.stripes[i])
+					continue;
+
+				int y = (int)i * _stripe;
+				SDL_Rect r = { t.src.x, t.src.y + y, t.src.w, std::min(_stripe, t.src.h - y) };
+				SDL_Rect m = map(r, dst, o);
+				if (!pass && !SDL_HasIntersection(&m, &view))
+					continue;
+
+				upload_stripe(t, i);
+				spent += (size_t)r.h * (size_t)_source->pitch;
+				if (spent >= budget)
+					return finish();
+			}
+		}
+	}
+
+	return finish();
+}
+
+void Tiles::upload(SDL_Surface* s)
+{
+	// Upload everything at once
+	begin(s);
+	for (Tile& t : _tiles) {
+		for (size_t i = 0; i < t.stripes.size(); ++i)
+			upload_stripe(t, i);
+	}
+	finish();
+}
+
+void Tiles::draw(const SDL_Rect& dst, const Orientation& o) const
+{
+	if (!_w || !_h)
+		return;
+
+	RenderWindow& win = RenderWindow::get_instance();
+	SDL_Rect view = { 0, 0, 0, 0 };
+	win.get_size(&view.w, &view.h);
+
+	for (const Tile& t : _tiles) {
+		// Skip tiles outside the window
+		SDL_Rect r = map(t.src, dst, o);
+		if (!SDL_HasIntersection(&r, &view))
+			continue;
+
+		if (t.uploaded == t.stripes.size()) {
+			win.render(t.texture, nullptr, &r, o);
+			continue;
+		}
+
+		// Partially uploaded, draw finished stripes only
+		for (size_t i = 0; i < t.stripes.size(); ++i) {
+			if (!t.stripes[i])
+				continue;
+
+			int y = (int)i * _stripe;
+			SDL_Rect src = { 0, y, t.src.w, std::min(_stripe, t.src.h - y) };
+			SDL_Rect abs = { t.src.x, t.src.y + y, src.w, src.h };
+			SDL_Rect d = map(abs, dst, o);
+			win.render(t.texture, &src, &d, o);
+		}
+	}
+}
+
+void Tiles::clear()
+{
+	// Textures go back to the pool for re-use
+	for (Tile& t : _tiles)
+		TexturePool::get_instance().recycle(t.texture);
+	_tiles.clear();
+
+	SDL_FreeSurface(_conv);
+	_conv = nullptr;
+	_source = nullptr;
+	_w = 0;
+	_h = 0;
+}
+
+bool Tiles::empty() const
+{
+	return _tiles.empty();
+}
+
+bool Tiles::ready() const
+{
+	for (const Tile& t : _tiles) {
+		if (t.uploaded != t.stripes.size())
+			return false;
+	}
+	return true;
+}
+
+size_t Tiles::get_bytes() const
+{
+	size_t n = 0;
+	for (const Tile& t : _tiles) {
+		Uint32 fmt;
+		SDL_QueryTexture(t.texture, &fmt, nullptr, nullptr, nullptr);
+		n += (size_t)t.src.w * (size_t)t.src.h * SDL_BYTESPERPIXEL(fmt);
+	}
+	return n;
+}
\ No newline at end of file
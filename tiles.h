@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include <SDL.h>
+#include "orient.h"
+
+/* Grid of streaming textures covering one surface, lets pages larger
+ * than the renderer's maximum texture size be drawn piecewise and
+ * uploads to be spread across frames in horizontal stripes, drawn in
+ * any orientation by the renderer */
+class Tiles {
+	struct Tile {
+		SDL_Rect src;
+		SDL_Texture* texture;
+		std::vector<bool> stripes;
+		size_t uploaded;
+	};
+
+	static constexpr int _tilesize = 2048;
+	static constexpr size_t _stripebytes = 4 << 20;
+	std::vector<Tile> _tiles;
+	SDL_Surface* _source;
+	SDL_Surface* _conv;
+	int _stripe;
+	int _w;
+	int _h;
+
+	SDL_Rect map(const SDL_Rect&, const SDL_Rect&, const Orientation&) const;
+	void upload_stripe(Tile&, size_t);
+	bool finish();
+public:
+	static constexpr size_t _framebytes = 16 << 20;
+
+	Tiles();
+	Tiles(Tiles&&);
+	Tiles& operator=(Tiles&&);
+	Tiles(const Tiles&) = delete;
+	Tiles& operator=(const Tiles&) = delete;
+	~Tiles();
+
+	void begin(SDL_Surface*);
+	bool step(const SDL_Rect&, const Orientation& = Orientation(), size_t = _framebytes);
+	void upload(SDL_Surface*);
+	void draw(const SDL_Rect&, const Orientation& = Orientation()) const;
+	void clear();
+
+	bool empty() const;
+	bool ready() const;
+	size_t get_bytes() const;
+};
\ No newline at end of file
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cctype>
 #include "util.h"
 
 using namespace std;
@@ -8,10 +10,63 @@ bool Util::is_image(const fs::path& p)
 	if (!fs::exists(p) || !fs::is_regular_file(p))
 		return false;
 
+	return has_image_ext(p);
+}
+
+bool Util::is_image(const fs::directory_entry& e)
+{
+	// Check the name first, the type is cached by the directory scan
+	error_code ec;
+	return has_image_ext(e.path()) && e.is_regular_file(ec);
+}
+
+bool Util::is_tar(const fs::path& p)
+{
+	string ext = p.extension().string();
+	return !ext.compare(".cbt") || !ext.compare(".tar");
+}
+
+bool Util::is_archive(const fs::path& p)
+{
+	if (!fs::exists(p) || !fs::is_regular_file(p))
+		return false;
+
+	string ext = p.extension().string();
+	return !ext.compare(".cbz") || !ext.compare(".zip") || is_tar(p);
+}
+
+bool Util::has_image_ext(const fs::path& p)
+{
 	string ext = p.extension().string();
 	return !ext.compare(".jpeg") || !ext.compare(".jpg") || !ext.compare(".png");
 }
 
+string Util::get_sort_key(const string& s)
+{
+	// Digit runs become '0', their length & the digits sans leading zeros,
+	// so numbers compare by value ("page2" < "page10"), letters fold case
+	string k;
+	k.reserve(s.size() + 8);
+	for (size_t i = 0; i < s.size();) {
+		if (!isdigit((unsigned char)s[i])) {
+			k += (char)tolower((unsigned char)s[i++]);
+			continue;
+		}
+
+		while (i + 1 < s.size() && s[i] == '0' && isdigit((unsigned char)s[i + 1]))
+			++i;
+		size_t j = i;
+		while (j < s.size() && isdigit((unsigned char)s[j]))
+			++j;
+
+		// Cap the length at 127 so it stays positive where char is signed
+		k += '0';
+		k += (char)min(j - i, (size_t)127);
+		k.append(s, i, j - i);
+		i = j;
+	}
+	return k;
+}
 
 std::filesystem::path Util::get_respath(const char* f)
 {
@@ -1,14 +1,17 @@
 #include <utility>
 #include "widget.h"
-#include "util.h"
+#include "atlas.h"
 
 using namespace std;
 
+unsigned Widget::_revision(0);
+
 Widget::Widget()
 	: _x(0)
 	, _y(0)
 	, _w(0)
 	, _h(0)
+	, _region({ 0, 0, 0, 0 })
 	, _state(IDLE)
 {}
 
@@ -18,59 +21,74 @@ Widget::Widget(Widget&& other)
 	, _y(other._y)
 	, _w(other._w)
 	, _h(other._h)
+	, _region(exchange(other._region, { 0, 0, 0, 0 }))
 	, _state(exchange(other._state, DISABLED))
 	, _handler(exchange(other._handler, function<void(Widget&)>()))
 {}
 
 void Widget::set_position(int x, int y)
 {
-	aquire(_mut);
+	if (x == _x && y == _y)
+		return;
 	_x = x;
 	_y = y;
+	++_revision;
 }
 
 void Widget::get_position(int *x, int *y) const
 {
-	aquire(_mut);
 	if (x) *x = _x;
 	if (y) *y = _y;
 }
 
 void Widget::get_size(int *w, int *h) const
 {
-	aquire(_mut);
 	if (w) *w = _w;
 	if (h) *h = _h;
 }
 
 bool Widget::contains(int x, int y) const
 {
-	aquire(_mut);
 	return (_x <= x && x <= _x + _w)
 		&& (_y <= y && y <= _y + _h);
 }
 
 void Widget::set_handler(function<void(Widget&)>&& f)
 {
-	aquire(_mut);
 	swap(_handler, f);
 }
 
 void Widget::trigger()
 {
-	aquire(_mut);
 	if (_handler && _state != DISABLED)
 		_handler(*this);
 }
 
 void Widget::set_state(const State s)
 {
-	aquire(_mut);
+	if (s == _state)
+		return;
 	_state = s;
+	++_revision;
 }
 
 Widget::State Widget::get_state() const
 {
-	aquire(_mut);
 	return _state;
+}
+
+void Widget::update()
+{
+	if (!_uflag)
+		return;
+	_uflag = false;
+
+	// Sprites live in the shared UI atlas instead of textures of their own
+	SpriteAtlas::get_instance().put(&_region, _surface);
+}
+
+unsigned Widget::get_revision()
+{
+	// Bumped on every visible change of any widget
+	return _revision;
 }
\ No newline at end of file
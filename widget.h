@@ -1,6 +1,5 @@
 #pragma once
 #include <functional>
-#include <mutex>
 #include "drawable.h"
 
 class Widget : public Drawable {
@@ -22,14 +21,20 @@ public:
 	virtual void set_state(const State);
 	State get_state() const;
 
+	void update() override;
+
 	virtual void draw() const = 0;
+
+	static unsigned get_revision();
 protected:
 	int _x;
 	int _y;
 	int _w;
 	int _h;
+	SDL_Rect _region;
 
 	State _state;
 	std::function<void(Widget&)> _handler;
-	mutable std::recursive_mutex _mut;
+
+	static unsigned _revision;
 };
\ No newline at end of file
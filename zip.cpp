@@ -0,0 +1,225 @@
+#include <climits>
+#include <zlib.h>
+#include "util.h"
+#include "zip.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+/* Little-endian field readers, archive data is unaligned */
+static Uint16 rd16(const Uint8* p)
+{
+	return (Uint16)(p[0] | (p[1] << 8));
+}
+
+static Uint32 rd32(const Uint8* p)
+{
+	return (Uint32)rd16(p) | ((Uint32)rd16(p + 2) << 16);
+}
+
+static Uint64 rd64(const Uint8* p)
+{
+	return (Uint64)rd32(p) | ((Uint64)rd32(p + 4) << 32);
+}
+
+Zip::Zip(const fs::path& p)
+	: _path(p)
+	, _file(p, false)
+{
+	error_code ec;
+	auto t = fs::last_write_time(p, ec);
+	_key = p.string() + '|' + to_string(_file.size()) + '|' + to_string(ec ? 0 : t.time_since_epoch().count()) + '|';
+}
+
+shared_ptr<Zip> Zip::open(const fs::path& p)
+{
+	shared_ptr<Zip> z(new Zip(p));
+	if (!z->_file || !z->parse())
+		return nullptr;
+	return z;
+}
+
+bool Zip::parse()
+{
+	const Uint8* d = _file.data();
+	Uint64 n = _file.size();
+	if (n < 22)
+		return false;
+
+	// Find end of central directory, followed by at most a 64k comment
+	Uint64 lo = (n > 22 + 0xFFFF ? n - 22 - 0xFFFF : 0);
+	Uint64 eocd = n;
+	for (Uint64 i = n - 22 + 1; i-- > lo;) {
+		if (rd32(d + i) == 0x06054b50) {
+			eocd = i;
+			break;
+		}
+	}
+	if (eocd == n)
+		return false;
+
+	Uint64 count = rd16(d + eocd + 10);
+	Uint64 cdsize = rd32(d + eocd + 12);
+	Uint64 cdoff = rd32(d + eocd + 16);
+
+	// Zip64 end of central directory, located just before the regular one
+	if ((count == 0xFFFF || cdoff == 0xFFFFFFFF) && eocd >= 20 && rd32(d + eocd - 20) == 0x07064b50) {
+		Uint64 z = rd64(d + eocd - 20 + 8);
+		if (n >= 56 && z <= n - 56 && rd32(d + z) == 0x06064b50) {
+			count = rd64(d + z + 32);
+			cdsize = rd64(d + z + 40);
+			cdoff = rd64(d + z + 48);
+		}
+	}
+	if (cdoff > n || cdsize > n - cdoff)
+		return false;
+
+	Uint64 p = cdoff;
+	for (Uint64 k = 0; k < count; ++k) {
+		if (p + 46 > n || rd32(d + p) != 0x02014b50)
+			return false;
+
+		Uint16 flags = rd16(d + p + 8);
+		Uint16 method = rd16(d + p + 10);
+		Uint64 csize = rd32(d + p + 20);
+		Uint64 usize = rd32(d + p + 24);
+		Uint16 namelen = rd16(d + p + 28);
+		Uint16 extlen = rd16(d + p + 30);
+		Uint16 comlen = rd16(d + p + 32);
+		Uint64 off = rd32(d + p + 42);
+		if (p + 46 + namelen + extlen + comlen > n)
+			return false;
+
+		// Zip64 extra field replaces saturated fields, in this order
+		const Uint8* x = d + p + 46 + namelen;
+		const Uint8* xe = x + extlen;
+		while (x + 4 <= xe) {
+			Uint16 id = rd16(x);
+			Uint16 len = rd16(x + 2);
+			const Uint8* f = x + 4;
+			const Uint8* fe = f + len;
+			if (fe > xe)
+				break;
+
+			if (id == 0x0001) {
+				if (usize == 0xFFFFFFFF && f + 8 <= fe) {
+					usize = rd64(f);
+					f += 8;
+				}
+				if (csize == 0xFFFFFFFF && f + 8 <= fe) {
+					csize = rd64(f);
+					f += 8;
+				}
+				if (off == 0xFFFFFFFF && f + 8 <= fe)
+					off = rd64(f);
+			}
+			x = fe;
+		}
+
+		string name((const char*)d + p + 46, namelen);
+		p += 46 + namelen + extlen + comlen;
+
+		// Keep unencrypted, stored or deflated images only
+		if ((flags & 1) || (method != 0 && method != 8) || !Util::has_image_ext(name))
+			continue;
+
+		_entries.push_back({ off, csize, usize, (Uint32)_names.size(), namelen, method });
+		_names += name;
+	}
+
+	return true;
+}
+
+size_t Zip::count() const
+{
+	return _entries.size();
+}
+
+string Zip::get_name(size_t i) const
+{
+	const Entry& e = _entries[i];
+	return _names.substr(e.name, e.namelen);
+}
+
+string Zip::get_key(size_t i) const
+{
+	return _key + get_name(i);
+}
+
+Buffer Zip::read(size_t i, size_t limit) const
+{
+	const Entry& e = _entries[i];
+	const Uint8* d = _file.data();
+	Uint64 n = _file.size();
+
+	// Member data follows the local header & its variable fields, the offset
+	// comes from the archive so test it without overflowing
+	if (n < 30 || e.offset > n - 30 || rd32(d + e.offset) != 0x04034b50)
+		return Buffer();
+
+	Uint64 start = e.offset + 30 + rd16(d + e.offset + 26) + rd16(d + e.offset + 28);
+	if (start > n || e.csize > n - start)
+		return Buffer();
+
+	// Stored members are handed out straight from the mapping
+	if (e.method == 0)
+		return Buffer(shared_from_this(), d + start, (size_t)e.csize);
+
+	if (e.csize > UINT_MAX || e.usize > UINT_MAX)
+		return Buffer();
+
+	// Inflate into a buffer the decoder reads from directly, stopping
+	// early when only the leading bytes are wanted
+	bool partial = (limit < e.usize);
+	auto out = make_shared<vector<Uint8>>(partial ? limit : (size_t)e.usize);
+
+	z_stream z = {};
+	if (inflateInit2(&z, -MAX_WBITS) != Z_OK)
+		return Buffer();
+
+	z.next_in = (Bytef*)(d + start);
+	z.avail_in = (uInt)e.csize;
+	z.next_out = out->data();
+	z.avail_out = (uInt)out->size();
+
+	int r = inflate(&z, (partial ? Z_NO_FLUSH : Z_FINISH));
+	size_t len = z.total_out;
+	inflateEnd(&z);
+
+	if (r != Z_STREAM_END && !(partial && r == Z_OK && !z.avail_out))
+		return Buffer();
+	return Buffer(out, out->data(), len);
+}
+
+vector<shared_ptr<Page>> Zip::get_pages() const
+{
+	vector<shared_ptr<Page>> v;
+	for (size_t i = 0; i < _entries.size(); ++i)
+		v.push_back(make_shared<ZipPage>(shared_from_this(), i));
+	return v;
+}
+
+ZipPage::ZipPage(shared_ptr<const Zip> z, size_t i)
+	: _zip(move(z))
+	, _index(i)
+{}
+
+string ZipPage::get_name() const
+{
+	return _zip->get_name(_index);
+}
+
+string ZipPage::get_key() const
+{
+	return _zip->get_key(_index);
+}
+
+Buffer ZipPage::read() const
+{
+	return _zip->read(_index);
+}
+
+Buffer ZipPage::read_header(size_t n) const
+{
+	return _zip->read(_index, n);
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <SDL.h>
+#include "mapped.h"
+#include "page.h"
+
+/* Random-access reader for ZIP (.cbz) archives, the central directory
+ * is parsed once into a compact index of image members */
+class Zip : public std::enable_shared_from_this<Zip> {
+	struct Entry {
+		Uint64 offset;
+		Uint64 csize;
+		Uint64 usize;
+		Uint32 name;
+		Uint16 namelen;
+		Uint16 method;
+	};
+
+	const std::filesystem::path _path;
+	MappedFile _file;
+	std::string _names;
+	std::vector<Entry> _entries;
+	std::string _key;
+
+	Zip(const std::filesystem::path&);
+	bool parse();
+public:
+	static std::shared_ptr<Zip> open(const std::filesystem::path&);
+
+	size_t count() const;
+	std::string get_name(size_t) const;
+	std::string get_key(size_t) const;
+	Buffer read(size_t, size_t = SIZE_MAX) const;
+
+	std::vector<std::shared_ptr<Page>> get_pages() const;
+};
+
+class ZipPage final : public Page {
+	const std::shared_ptr<const Zip> _zip;
+	const size_t _index;
+public:
+	ZipPage(std::shared_ptr<const Zip>, size_t);
+
+	std::string get_name() const override;
+	std::string get_key() const override;
+	Buffer read() const override;
+	Buffer read_header(size_t) const override;
+};
\ No newline at end of file